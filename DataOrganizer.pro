@@ -3,11 +3,17 @@
 #-------------------------------------------------
 
 # Qt Modules
-QT += core gui widgets multimedia multimediawidgets
+QT += core gui widgets multimedia multimediawidgets concurrent
 
 # Configuration
 CONFIG += c++17
 
+# gzip CSV export uses the system zlib where there is one
+unix {
+    LIBS += -lz
+    DEFINES += DATAORGANIZER_ZLIB
+}
+
 # Target Executable Name (used for CFBundleExecutable)
 TARGET = DataOrganizer
 
@@ -28,11 +34,71 @@ ICON = macos_icon.icns
 
 # Project Files
 SOURCES += \
+    caseautosave.cpp \
+    casebatch.cpp \
+    casebinaryformat.cpp \
+    casecatalog.cpp \
+    casedata.cpp \
+    casefile.cpp \
+    casejournal.cpp \
+    casejsonformat.cpp \
+    caseloader.cpp \
+    casemerger.cpp \
+    casesearchindex.cpp \
+    casetable.cpp \
+    casetablefilter.cpp \
+    casetablemodel.cpp \
+    casetableproxymodel.cpp \
+    csvexporter.cpp \
+    csvimporter.cpp \
+    diagnosticsdialog.cpp \
+    evidencehasher.cpp \
+    intervalindex.cpp \
+    jsonstreamreader.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    medialibrarymodel.cpp \
+    mediathumbnailer.cpp \
+    noteseditor.cpp \
+    perftrace.cpp \
+    startuptimer.cpp \
+    stringpool.cpp \
+    tiledimageview.cpp \
+    videoanalyzer.cpp \
+    videoframecache.cpp
 
 HEADERS += \
-    mainwindow.h
+    caseautosave.h \
+    casebatch.h \
+    casebinaryformat.h \
+    casecatalog.h \
+    casedata.h \
+    casefile.h \
+    casejournal.h \
+    casejsonformat.h \
+    caseloader.h \
+    casemerger.h \
+    casesearchindex.h \
+    casetable.h \
+    casetablefilter.h \
+    casetablemodel.h \
+    casetableproxymodel.h \
+    csvexporter.h \
+    csvimporter.h \
+    diagnosticsdialog.h \
+    evidencehasher.h \
+    intervalindex.h \
+    jsonstreamreader.h \
+    mainwindow.h \
+    medialibrarymodel.h \
+    mediathumbnailer.h \
+    noteseditor.h \
+    perftrace.h \
+    startuptimer.h \
+    stringpool.h \
+    tiledimageview.h \
+    videoanalyzer.h \
+    videoframecache.h
 
 TEMPLATE = app
 RESOURCES += resources.qrc
@@ -0,0 +1,60 @@
+#-------------------------------------------------
+# Benchmarks for Data Organizer
+#
+# Builds DataOrganizerBenchmark from the application's own case, table and
+# export sources. It runs without a display and prints JSON results; see
+# main.cpp for the options.
+#-------------------------------------------------
+
+QT += core gui concurrent
+QT -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Same zlib as the application, for gzip CSV export
+unix {
+    LIBS += -lz
+    DEFINES += DATAORGANIZER_ZLIB
+}
+
+# Peak memory comes from the process counters
+win32: LIBS += -lpsapi
+
+TARGET = DataOrganizerBenchmark
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../casebinaryformat.cpp \
+    ../casedata.cpp \
+    ../casefile.cpp \
+    ../casejournal.cpp \
+    ../casejsonformat.cpp \
+    ../casetable.cpp \
+    ../casetablefilter.cpp \
+    ../casetablemodel.cpp \
+    ../casetableproxymodel.cpp \
+    ../csvexporter.cpp \
+    ../jsonstreamreader.cpp \
+    ../perftrace.cpp \
+    ../stringpool.cpp \
+    main.cpp \
+    syntheticcase.cpp
+
+HEADERS += \
+    ../casebinaryformat.h \
+    ../casedata.h \
+    ../casefile.h \
+    ../casejournal.h \
+    ../casejsonformat.h \
+    ../casetable.h \
+    ../casetablefilter.h \
+    ../casetablemodel.h \
+    ../casetableproxymodel.h \
+    ../csvexporter.h \
+    ../jsonstreamreader.h \
+    ../perftrace.h \
+    ../stringpool.h \
+    syntheticcase.h
@@ -0,0 +1,453 @@
+// Benchmarks for the persistence and table paths of Data Organizer.
+//
+// Generates a reproducible synthetic case and times the code behind reading
+// and saving a case, CSV export, adding and removing table rows, and sorting
+// and filtering a table view, without showing a window. Prints one JSON
+// document with the throughput, latency percentiles and peak memory of each
+// benchmark, for comparing builds:
+//
+//     DataOrganizerBenchmark --entities 1000000 --iterations 5 -o results.json
+//     DataOrganizerBenchmark --generate big.osintcase --entities 1000000
+
+#include "casefile.h"
+#include "casetablemodel.h"
+#include "casetableproxymodel.h"
+#include "csvexporter.h"
+#include "perftrace.h"
+#include "syntheticcase.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QUndoStack>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr int ResultsVersion = 1;
+
+struct Settings {
+    SyntheticCaseOptions caseOptions;
+    int iterations = 5;
+    int operations = 10000;
+    int removedRows = 1000;
+    QStringList only;
+};
+
+qint64 peakRssBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize);
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if defined(Q_OS_DARWIN)
+    return qint64(usage.ru_maxrss);
+#else
+    return qint64(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return -1;
+#endif
+}
+
+double percentile(const QList<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    const qsizetype i = qMin(sorted.size() - 1, qsizetype(p / 100.0 * double(sorted.size() - 1) + 0.5));
+    return double(sorted.at(i)) / 1e6;
+}
+
+// Times `iterations` runs of `run`, each after an untimed `prepare`. `items`
+// and `bytes` are what one run processes, for the throughput.
+class Benchmark
+{
+public:
+    Benchmark(const QString &name, qint64 items, qint64 bytes = 0) : name(name), items(items), bytes(bytes) {}
+
+    QJsonObject measure(int iterations, const std::function<void()> &run, const std::function<void()> &prepare = {})
+    {
+        QList<qint64> latencies;
+        latencies.reserve(iterations);
+        qint64 total = 0;
+        QElapsedTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            if (prepare)
+                prepare();
+            timer.start();
+            run();
+            const qint64 elapsed = timer.nsecsElapsed();
+            latencies.append(elapsed);
+            total += elapsed;
+        }
+        return result(latencies, total);
+    }
+
+    QJsonObject result(QList<qint64> latencies, qint64 total) const
+    {
+        std::sort(latencies.begin(), latencies.end());
+        const double seconds = double(total) / 1e9;
+        const qsizetype runs = latencies.size();
+        QJsonObject object;
+        object["name"] = name;
+        object["iterations"] = qint64(runs);
+        object["items_per_iteration"] = items;
+        if (seconds > 0) {
+            object["items_per_second"] = double(items) * double(runs) / seconds;
+            if (bytes > 0)
+                object["megabytes_per_second"] = double(bytes) * double(runs) / seconds / (1024.0 * 1024.0);
+        }
+        if (bytes > 0)
+            object["bytes_per_iteration"] = bytes;
+        QJsonObject latency;
+        latency["min"] = percentile(latencies, 0);
+        latency["p50"] = percentile(latencies, 50);
+        latency["p90"] = percentile(latencies, 90);
+        latency["p99"] = percentile(latencies, 99);
+        latency["max"] = percentile(latencies, 100);
+        latency["mean"] = runs > 0 ? double(total) / double(runs) / 1e6 : 0.0;
+        object["latency_ms"] = latency;
+        object["peak_rss_bytes"] = peakRssBytes();
+        return object;
+    }
+
+private:
+    QString name;
+    qint64 items;
+    qint64 bytes;
+};
+
+qint64 rowCount(const CaseData &data)
+{
+    qint64 rows = 0;
+    for (int t = 0; t < CaseData::TableCount; ++t)
+        rows += data.table(CaseData::Table(t)).rowCount();
+    return rows;
+}
+
+bool fail(const QString &message)
+{
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+    return false;
+}
+
+class Runner
+{
+public:
+    Runner(const Settings &settings, const QString &workDirectory) : settings(settings), directory(workDirectory) {}
+
+    bool run(QJsonArray *results)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        data = SyntheticCase::generate(settings.caseOptions);
+        const qint64 elapsed = timer.nsecsElapsed();
+        results->append(Benchmark("generate", rowCount(data)).result({elapsed}, elapsed));
+
+        return persistence(CaseFile::Json, "json", results) && persistence(CaseFile::Binary, "binary", results)
+            && csvExport(results) && tableEdits(results) && tableView(results);
+    }
+
+private:
+    bool wanted(const QString &name) const
+    {
+        return settings.only.isEmpty()
+            || std::any_of(settings.only.cbegin(), settings.only.cend(), [&name](const QString &prefix) { return name.startsWith(prefix); });
+    }
+
+    // writeCaseData() and readCaseData()
+    bool persistence(CaseFile::Format format, const QString &suffix, QJsonArray *results)
+    {
+        const QString path = QDir(directory).filePath("synthetic." + suffix);
+        const qint64 rows = rowCount(data);
+        QString errorString;
+        bool ok = true;
+        if (wanted("write_" + suffix)) {
+            // The size is only known after the first write
+            if (!CaseFile::write(path, format, data, &errorString))
+                return fail(errorString);
+            Benchmark write("write_" + suffix, rows, QFileInfo(path).size());
+            results->append(write.measure(settings.iterations, [&]() { ok = CaseFile::write(path, format, data, &errorString) && ok; }));
+            if (!ok)
+                return fail(errorString);
+        }
+        if (wanted("read_" + suffix)) {
+            if (!QFileInfo::exists(path) && !CaseFile::write(path, format, data, &errorString))
+                return fail(errorString);
+            Benchmark read("read_" + suffix, rows, QFileInfo(path).size());
+            results->append(read.measure(settings.iterations, [&]() {
+                CaseData loaded;
+                ok = CaseFile::read(path, &loaded, &errorString) && ok;
+            }));
+            if (!ok)
+                return fail(errorString);
+        }
+        return true;
+    }
+
+    // exportTableToCsv(), every table the menu exports
+    bool csvExport(QJsonArray *results)
+    {
+        for (bool gzip : {false, true}) {
+            const QString name = gzip ? "export_csv_gzip" : "export_csv";
+            if (!wanted(name) || (gzip && !CsvExporter::isGzipSupported()))
+                continue;
+            CsvDialect dialect;
+            dialect.gzip = gzip;
+            QList<CsvExporter::Target> targets;
+            qint64 rows = 0;
+            for (CaseData::Table t : {CaseData::Entities, CaseData::Events, CaseData::Resources}) {
+                targets.append({QDir(directory).filePath(CaseData::tableKey(t) + (gzip ? ".csv.gz" : ".csv")), data.table(t)});
+                rows += data.table(t).rowCount();
+            }
+            QString errorString;
+            QList<qint64> latencies;
+            qint64 total = 0;
+            for (int i = 0; i < settings.iterations; ++i) {
+                CsvExporter exporter(targets, dialect);
+                QElapsedTimer timer;
+                timer.start();
+                exporter.start();
+                exporter.wait();
+                latencies.append(timer.nsecsElapsed());
+                total += latencies.last();
+                if (exporter.result() != CsvExporter::Exported)
+                    return fail(exporter.errorString());
+            }
+            qint64 bytes = 0;
+            for (const CsvExporter::Target &target : std::as_const(targets))
+                bytes += QFileInfo(target.filePath).size();
+            results->append(Benchmark(name, rows, bytes).result(latencies, total));
+        }
+        return true;
+    }
+
+    // addEntityRow() and removeSelectedTableRow(), with the undo history the window keeps
+    bool tableEdits(QJsonArray *results)
+    {
+        CaseTableModel model(CaseData::columns(CaseData::Entities));
+        QUndoStack undoStack;
+        model.setUndoStack(&undoStack);
+
+        if (wanted("add_entity_row")) {
+            model.setTable(data.entities);
+            int next = 0;
+            results->append(Benchmark("add_entity_row", 1).measure(settings.operations, [&]() {
+                model.insertCells(model.rowCount(), {CaseTable::formatMediaTime(qint64(next++) * 1000), "Entity", "Person", QString()}, "Add Entity");
+            }));
+            undoStack.clear();
+        }
+
+        // Scattered rows, as picked from a sorted view, and one contiguous block
+        QRandomGenerator random(quint32(settings.caseOptions.seed));
+        QList<int> rows;
+        auto pickScattered = [&]() {
+            rows.clear();
+            for (int i = 0; i < settings.removedRows && model.rowCount() > 0; ++i)
+                rows.append(int(random.bounded(model.rowCount())));
+        };
+        auto pickBlock = [&]() {
+            const int count = qMin(settings.removedRows, model.rowCount());
+            const int first = int(random.bounded(model.rowCount() - count + 1));
+            rows.resize(count);
+            std::iota(rows.begin(), rows.end(), first);
+        };
+        for (bool scattered : {true, false}) {
+            const QString name = scattered ? "remove_rows_scattered" : "remove_rows_block";
+            if (!wanted(name))
+                continue;
+            model.setTable(data.entities);
+            undoStack.clear();
+            results->append(Benchmark(name, settings.removedRows).measure(settings.iterations, [&]() { model.removeRowSet(rows); }, [&]() {
+                // Put the previous removal back so every run sees the whole table
+                if (undoStack.canUndo())
+                    undoStack.undo();
+                scattered ? pickScattered() : pickBlock();
+            }));
+            if (wanted("undo_" + name)) {
+                results->append(Benchmark("undo_" + name, settings.removedRows).measure(settings.iterations, [&]() { undoStack.undo(); }, [&]() {
+                    if (!undoStack.canUndo()) {
+                        scattered ? pickScattered() : pickBlock();
+                        model.removeRowSet(rows);
+                    }
+                }));
+            }
+            undoStack.clear();
+        }
+        return true;
+    }
+
+    // Sorting by clicking a header and typing in the filter bar
+    bool tableView(QJsonArray *results)
+    {
+        CaseTableModel model(CaseData::columns(CaseData::Entities));
+        model.setTable(data.entities);
+        CaseTableProxyModel proxy;
+        proxy.setSourceModel(&model);
+        const qint64 rows = model.rowCount();
+        const QList<CaseTable::Column> columns = CaseData::columns(CaseData::Entities);
+        for (int column = 0; column < columns.size(); ++column) {
+            const QString name = "sort_entities_" + columns.at(column).header.toLower().replace(' ', '_');
+            if (!wanted(name))
+                continue;
+            Qt::SortOrder order = Qt::AscendingOrder;
+            results->append(Benchmark(name, rows).measure(settings.iterations, [&]() { proxy.sort(column, order); }, [&]() {
+                order = order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+            }));
+        }
+        proxy.sort(-1);
+        const QStringList filters = {"acme", "type:person", "ac -person", "00:01"};
+        for (const QString &filter : filters) {
+            const QString name = "filter_entities \"" + filter + '"';
+            if (!wanted("filter_entities"))
+                continue;
+            results->append(Benchmark(name, rows).measure(settings.iterations, [&]() { proxy.setFilterText(filter); }, [&]() {
+                proxy.setFilterText(QString());
+            }));
+        }
+        return true;
+    }
+
+    const Settings &settings;
+    const QString directory;
+    CaseData data;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Models and views work without a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("DataOrganizerBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks reading, saving, exporting and editing a synthetic case.");
+    parser.addHelpOption();
+    const QCommandLineOption entitiesOption("entities", "Entity rows.", "rows", "100000");
+    const QCommandLineOption eventsOption("events", "Event rows.", "rows", "100000");
+    const QCommandLineOption resourcesOption("resources", "Resource rows.", "rows", "20000");
+    const QCommandLineOption mediaOption("media", "Media rows.", "rows", "2000");
+    const QCommandLineOption hashesOption("hashes", "Hash rows.", "rows", "2000");
+    const QCommandLineOption cellLengthOption("cell-length", "Average length of free text cells.", "characters", "32");
+    const QCommandLineOption notesOption("notes-length", "Length of the notes.", "characters", "1048576");
+    const QCommandLineOption unicodeOption("unicode", "Percentage of words outside Latin-1.", "percent", "10");
+    const QCommandLineOption distinctOption("distinct", "Percentage of free text cells that are new strings.", "percent", "50");
+    const QCommandLineOption seedOption("seed", "Seed of the generated case.", "seed", "1");
+    const QCommandLineOption iterationsOption({"n", "iterations"}, "Runs of each whole-case benchmark.", "count", "5");
+    const QCommandLineOption operationsOption("operations", "Rows added by the add row benchmark.", "count", "10000");
+    const QCommandLineOption removedOption("removed-rows", "Rows removed at a time.", "count", "1000");
+    const QCommandLineOption onlyOption("only", "Only run benchmarks whose name starts with this (repeatable).", "name");
+    const QCommandLineOption outputOption({"o", "output"}, "Write the results here instead of to standard output.", "file");
+    const QCommandLineOption directoryOption({"d", "work-dir"}, "Directory for the files written (default: a temporary one).", "directory");
+    const QCommandLineOption generateOption("generate", "Only write the generated case to this file.", "file");
+    const QCommandLineOption traceOption("trace", "Record trace points while benchmarking, to compare against a run without.");
+    parser.addOptions({entitiesOption, eventsOption, resourcesOption, mediaOption, hashesOption, cellLengthOption,
+                       notesOption, unicodeOption, distinctOption, seedOption, iterationsOption, operationsOption,
+                       removedOption, onlyOption, outputOption, directoryOption, generateOption, traceOption});
+    parser.process(app);
+
+    Settings settings;
+    SyntheticCaseOptions &caseOptions = settings.caseOptions;
+    caseOptions.rows[CaseData::Entities] = parser.value(entitiesOption).toInt();
+    caseOptions.rows[CaseData::Events] = parser.value(eventsOption).toInt();
+    caseOptions.rows[CaseData::Resources] = parser.value(resourcesOption).toInt();
+    caseOptions.rows[CaseData::Media] = parser.value(mediaOption).toInt();
+    caseOptions.rows[CaseData::Hashes] = parser.value(hashesOption).toInt();
+    caseOptions.cellLength = parser.value(cellLengthOption).toInt();
+    caseOptions.notesLength = parser.value(notesOption).toLongLong();
+    caseOptions.unicodePercent = qBound(0, parser.value(unicodeOption).toInt(), 100);
+    caseOptions.distinctPercent = qBound(0, parser.value(distinctOption).toInt(), 100);
+    caseOptions.seed = parser.value(seedOption).toULongLong();
+    settings.iterations = qMax(1, parser.value(iterationsOption).toInt());
+    settings.operations = qMax(1, parser.value(operationsOption).toInt());
+    settings.removedRows = qMax(1, parser.value(removedOption).toInt());
+    settings.only = parser.values(onlyOption);
+    PerfTrace::setEnabled(parser.isSet(traceOption));
+
+    if (parser.isSet(generateOption)) {
+        QString errorString;
+        if (!CaseFile::write(parser.value(generateOption), SyntheticCase::generate(caseOptions), &errorString)) {
+            std::fprintf(stderr, "%s\n", qPrintable(errorString));
+            return 1;
+        }
+        return 0;
+    }
+
+    QTemporaryDir temporaryDirectory;
+    const QString directory = parser.isSet(directoryOption) ? parser.value(directoryOption) : temporaryDirectory.path();
+    if (!QDir().mkpath(directory)) {
+        std::fprintf(stderr, "Could not create %s\n", qPrintable(directory));
+        return 1;
+    }
+
+    QJsonArray benchmarks;
+    Runner runner(settings, directory);
+    const bool ok = runner.run(&benchmarks);
+
+    QJsonObject options;
+    options["entities"] = caseOptions.rows[CaseData::Entities];
+    options["events"] = caseOptions.rows[CaseData::Events];
+    options["resources"] = caseOptions.rows[CaseData::Resources];
+    options["media"] = caseOptions.rows[CaseData::Media];
+    options["hashes"] = caseOptions.rows[CaseData::Hashes];
+    options["cell_length"] = caseOptions.cellLength;
+    options["notes_length"] = caseOptions.notesLength;
+    options["unicode_percent"] = caseOptions.unicodePercent;
+    options["distinct_percent"] = caseOptions.distinctPercent;
+    options["seed"] = QString::number(caseOptions.seed);
+    options["iterations"] = settings.iterations;
+    options["operations"] = settings.operations;
+    options["removed_rows"] = settings.removedRows;
+    options["trace"] = PerfTrace::isEnabled();
+
+    QJsonObject report;
+    report["version"] = ResultsVersion;
+    report["qt_version"] = QString::fromLatin1(qVersion());
+    report["build_abi"] = QSysInfo::buildAbi();
+    report["cpu_threads"] = QThread::idealThreadCount();
+    report["options"] = options;
+    report["benchmarks"] = benchmarks;
+    report["peak_rss_bytes"] = peakRssBytes();
+    report["completed"] = ok;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            std::fprintf(stderr, "Could not write %s: %s\n", qPrintable(file.fileName()), qPrintable(file.errorString()));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    }
+    return ok ? 0 : 1;
+}
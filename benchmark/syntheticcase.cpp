@@ -0,0 +1,134 @@
+#include "syntheticcase.h"
+
+#include <QRandomGenerator>
+
+#include <functional>
+#include <iterator>
+
+namespace {
+
+constexpr int AppendBatchRows = 4096;
+// 2023-01-01 00:00:00 UTC, so access dates look like dates
+constexpr qint64 FirstAccessDate = 1672531200000;
+constexpr qint64 MSecsPerYear = 365LL * 86400 * 1000;
+constexpr qint64 MediaLength = 4LL * 3600 * 1000;
+
+const char *const AsciiWords[] = {
+    "acme", "vehicle", "meeting", "north", "harbour", "account", "transfer", "camera", "entrance", "silver",
+    "station", "courier", "package", "invoice", "signal", "window", "contact", "delivery", "river", "office",
+};
+const char16_t *const UnicodeWords[] = {
+    u"Δέλτα", u"Москва", u"東京", u"서울", u"القاهرة", u"Zürich", u"São", u"İstanbul", u"🚗", u"📞",
+};
+const char *const EntityTypes[] = {"Person", "Organization", "Vehicle", "Location", "Phone", "Email", "Account"};
+
+class Generator
+{
+public:
+    explicit Generator(const SyntheticCaseOptions &options) : options(options), random(options.seed) {}
+
+    QString word()
+    {
+        if (int(random.bounded(100)) < options.unicodePercent)
+            return QString::fromUtf16(UnicodeWords[random.bounded(int(std::size(UnicodeWords)))]);
+        return QString::fromLatin1(AsciiWords[random.bounded(int(std::size(AsciiWords)))]);
+    }
+
+    // Words up to about `length` characters; a repeat of an earlier cell as often as asked
+    QString text(int length)
+    {
+        if (!recent.isEmpty() && int(random.bounded(100)) >= options.distinctPercent)
+            return recent.at(random.bounded(int(recent.size())));
+        QString result;
+        const int target = qMax(1, length / 2 + int(random.bounded(length + 1)));
+        while (result.size() < target) {
+            if (!result.isEmpty())
+                result += u' ';
+            result += word();
+        }
+        result += u' ' + QString::number(random.bounded(1000000));
+        if (recent.size() < 4096)
+            recent.append(result);
+        else
+            recent[random.bounded(int(recent.size()))] = result;
+        return result;
+    }
+
+    qint64 mediaTime() { return random.bounded(MediaLength / 1000) * 1000; }
+    quint32 bounded(quint32 limit) { return random.bounded(limit); }
+
+    QString hex(int length)
+    {
+        static const char digits[] = "0123456789abcdef";
+        QString result(length, Qt::Uninitialized);
+        for (int i = 0; i < length; ++i)
+            result[i] = QLatin1Char(digits[random.bounded(16)]);
+        return result;
+    }
+
+private:
+    const SyntheticCaseOptions &options;
+    QRandomGenerator64 random;
+    QStringList recent;
+};
+
+void fillTable(CaseTable &table, int rows, const std::function<void(QStringList &, int)> &row)
+{
+    QStringList cells;
+    for (int r = 0; r < rows; ++r) {
+        row(cells, r);
+        if (cells.size() >= qsizetype(AppendBatchRows) * table.columnCount()) {
+            table.appendRows(cells);
+            cells.clear();
+        }
+    }
+    table.appendRows(cells);
+}
+
+} // namespace
+
+CaseData SyntheticCase::generate(const SyntheticCaseOptions &options)
+{
+    Generator generator(options);
+    const int length = qMax(1, options.cellLength);
+    CaseData data;
+    data.caseName = "Synthetic case " + QString::number(options.seed);
+    data.subjectTarget = generator.text(length);
+
+    fillTable(data.entities, options.rows[CaseData::Entities], [&](QStringList &cells, int) {
+        cells << CaseTable::formatMediaTime(generator.mediaTime()) << generator.text(length / 2)
+              << QString::fromLatin1(EntityTypes[generator.bounded(quint32(std::size(EntityTypes)))])
+              << generator.text(length);
+    });
+    fillTable(data.events, options.rows[CaseData::Events], [&](QStringList &cells, int) {
+        const qint64 start = generator.mediaTime();
+        cells << CaseTable::formatMediaTime(start) << CaseTable::formatMediaTime(start + generator.bounded(120) * 1000)
+              << generator.text(length * 2);
+    });
+    fillTable(data.resources, options.rows[CaseData::Resources], [&](QStringList &cells, int row) {
+        cells << QString("https://example.org/%1/%2").arg(row).arg(generator.word()) << generator.text(length)
+              << CaseTable::formatDateTime(FirstAccessDate + qint64(generator.bounded(quint32(MSecsPerYear / 1000))) * 1000);
+    });
+    fillTable(data.media, options.rows[CaseData::Media], [&](QStringList &cells, int row) {
+        cells << QString("/evidence/media/clip_%1.mp4").arg(row, 6, 10, QLatin1Char('0')) << generator.text(length);
+    });
+    fillTable(data.hashes, options.rows[CaseData::Hashes], [&](QStringList &cells, int row) {
+        cells << QString("/evidence/media/clip_%1.mp4").arg(row, 6, 10, QLatin1Char('0'))
+              << QString::number(generator.bounded(1u << 31))
+              << CaseTable::formatDateTime(FirstAccessDate + qint64(generator.bounded(quint32(MSecsPerYear / 1000))) * 1000)
+              << generator.hex(64);
+    });
+
+    QString notes;
+    notes.reserve(options.notesLength + length * 2);
+    while (notes.size() < options.notesLength) {
+        notes += u'[' + CaseTable::formatMediaTime(generator.mediaTime()) + u"] ";
+        notes += generator.text(length * 2);
+        notes += generator.bounded(4) == 0 ? QStringLiteral("\n\n") : QStringLiteral(". ");
+    }
+    notes.truncate(options.notesLength);
+    if (!notes.isEmpty() && notes.back().isHighSurrogate())
+        notes.chop(1);
+    data.notes = notes;
+    return data;
+}
@@ -0,0 +1,27 @@
+#ifndef SYNTHETICCASE_H
+#define SYNTHETICCASE_H
+
+#include "casedata.h"
+
+// Shape of a generated case. The same options and seed always produce the
+// same case, so timings from different builds are comparable.
+struct SyntheticCaseOptions
+{
+    quint64 seed = 1;
+    int rows[CaseData::TableCount] = {100000, 100000, 20000, 2000, 2000};
+    int cellLength = 32;      // average length of free text cells, in characters
+    qint64 notesLength = 1024 * 1024;
+    int unicodePercent = 10;  // share of words outside Latin-1, including emoji
+    int distinctPercent = 50; // share of free text cells that are new strings rather than repeats
+};
+
+// Generates a case file's worth of realistic looking data: entities with media
+// timestamps and types, event intervals, resource URLs with access dates, media
+// and hash rows, and notes with "[hh:mm:ss]" references.
+class SyntheticCase
+{
+public:
+    static CaseData generate(const SyntheticCaseOptions &options);
+};
+
+#endif // SYNTHETICCASE_H
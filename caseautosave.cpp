@@ -0,0 +1,134 @@
+#include "caseautosave.h"
+#include "casebinaryformat.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+
+// The case file a snapshot was taken from is kept next to it
+QString sourcePath(const QString &snapshotPath)
+{
+    return snapshotPath + QStringLiteral(".source");
+}
+
+QString lockPath(const QString &snapshotPath)
+{
+    return snapshotPath + QStringLiteral(".lock");
+}
+
+void removeSnapshot(const QString &snapshotPath)
+{
+    QFile::remove(snapshotPath);
+    QFile::remove(sourcePath(snapshotPath));
+}
+
+// Snapshots whose session no longer holds their lock, newest first
+QStringList staleSnapshots(const QString &directory)
+{
+    QStringList snapshots;
+    const QFileInfoList entries = QDir(directory).entryInfoList(
+        {QStringLiteral("*.") + CaseBinaryFormat::FileSuffix}, QDir::Files, QDir::Time);
+    for (const QFileInfo &entry : entries) {
+        const QString path = entry.absoluteFilePath();
+        QLockFile lock(lockPath(path));
+        if (lock.tryLock(0)) {
+            lock.unlock();
+            snapshots.append(path);
+        }
+    }
+    return snapshots;
+}
+
+} // namespace
+
+CaseAutosave::CaseAutosave(QObject *parent)
+    : QObject(parent), watcher(new QFutureWatcher<QString>(this))
+{
+    const QString directory = autosaveDirectory();
+    QDir().mkpath(directory);
+    snapshotPath = QDir(directory).filePath(QStringLiteral("session-%1-%2.%3")
+                                                .arg(QDateTime::currentMSecsSinceEpoch())
+                                                .arg(QCoreApplication::applicationPid())
+                                                .arg(CaseBinaryFormat::FileSuffix));
+    lockFile = new QLockFile(lockPath(snapshotPath));
+    if (!lockFile->tryLock(0))
+        qWarning("Couldn't lock the autosave snapshot %s", qPrintable(snapshotPath));
+    connect(watcher, &QFutureWatcherBase::finished, this, &CaseAutosave::saveFinished);
+}
+
+CaseAutosave::~CaseAutosave()
+{
+    watcher->waitForFinished();
+    if (discardPending)
+        removeSnapshot(snapshotPath);
+    delete lockFile;
+}
+
+bool CaseAutosave::save(const CaseData &snapshot, const QString &casePath)
+{
+    if (watcher->isRunning())
+        return false;
+    const QString path = snapshotPath;
+    watcher->setFuture(QtConcurrent::run([path, snapshot, casePath]() {
+        QString errorString;
+        if (!CaseBinaryFormat::write(path, snapshot, &errorString))
+            return errorString;
+        QSaveFile source(sourcePath(path));
+        if (!source.open(QIODevice::WriteOnly) || source.write(casePath.toUtf8()) < 0 || !source.commit())
+            return QStringLiteral("Couldn't write autosave source: ") + source.errorString();
+        return QString();
+    }));
+    return true;
+}
+
+void CaseAutosave::saveFinished()
+{
+    const QString errorString = watcher->result();
+    if (discardPending) {
+        discardPending = false;
+        removeSnapshot(snapshotPath);
+        return;
+    }
+    if (!errorString.isEmpty())
+        qWarning("Autosave failed: %s", qPrintable(errorString));
+}
+
+void CaseAutosave::discard()
+{
+    // The snapshot being written is already obsolete; it goes when the write ends
+    if (watcher->isRunning()) {
+        discardPending = true;
+        return;
+    }
+    removeSnapshot(snapshotPath);
+}
+
+QString CaseAutosave::recoverableSnapshot(QString *casePath)
+{
+    const QStringList snapshots = staleSnapshots(autosaveDirectory());
+    if (snapshots.isEmpty())
+        return QString();
+    // The source is written after the snapshot; a crash in between leaves it unnamed
+    QFile source(sourcePath(snapshots.first()));
+    *casePath = source.open(QIODevice::ReadOnly) ? QString::fromUtf8(source.readAll()) : QString();
+    return snapshots.first();
+}
+
+void CaseAutosave::discardRecoverable()
+{
+    const QStringList snapshots = staleSnapshots(autosaveDirectory());
+    for (const QString &snapshot : snapshots) {
+        removeSnapshot(snapshot);
+        QFile::remove(lockPath(snapshot));
+    }
+}
+
+QString CaseAutosave::autosaveDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/autosave");
+}
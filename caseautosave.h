@@ -0,0 +1,48 @@
+#ifndef CASEAUTOSAVE_H
+#define CASEAUTOSAVE_H
+
+#include "casedata.h"
+
+#include <QFutureWatcher>
+#include <QLockFile>
+#include <QObject>
+
+// Periodic crash-recovery snapshots of the open case. save() takes a copy of
+// the case, which only shares the implicitly shared tables, and writes it in
+// the binary format on a worker thread, so the GUI thread never serializes.
+// Each running window owns one snapshot in the autosave directory, guarded by
+// a lock file; a snapshot whose lock is no longer held was left behind by a
+// session that crashed and can be recovered.
+class CaseAutosave : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CaseAutosave(QObject *parent = nullptr);
+    ~CaseAutosave();
+
+    // Starts writing a snapshot unless the previous one is still being written.
+    bool save(const CaseData &snapshot, const QString &casePath);
+    bool isSaving() const { return watcher->isRunning(); }
+    // The case was saved or closed: this session's snapshot is no longer needed.
+    // A snapshot still being written is removed once it is done, without waiting.
+    void discard();
+
+    // Newest snapshot left behind by a crashed session, and the case file it was
+    // taken from (empty if the case had never been saved).
+    static QString recoverableSnapshot(QString *casePath);
+    static void discardRecoverable();
+
+private slots:
+    void saveFinished();
+
+private:
+    static QString autosaveDirectory();
+
+    QString snapshotPath;
+    QLockFile *lockFile = nullptr;
+    QFutureWatcher<QString> *watcher;
+    bool discardPending = false;
+};
+
+#endif // CASEAUTOSAVE_H
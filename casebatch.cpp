@@ -0,0 +1,224 @@
+#include "casebatch.h"
+#include "casebinaryformat.h"
+#include "casefile.h"
+#include "casemerger.h"
+#include "csvexporter.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QThreadPool>
+
+#include <atomic>
+#include <cstdio>
+
+namespace {
+
+struct JobResult {
+    bool ok = false;
+    QString message;
+};
+
+struct Options {
+    QString command;
+    QString outputDirectory;
+    QString output;
+    QString format;
+    CsvDialect dialect;
+    MergeOptions merge;
+};
+
+QString outputPath(const Options &options, const QString &casePath, const QString &fileName)
+{
+    const QString directory = options.outputDirectory.isEmpty() ? QFileInfo(casePath).absolutePath()
+                                                                : options.outputDirectory;
+    return QDir(directory).filePath(fileName);
+}
+
+QString describe(const CaseData &data)
+{
+    QStringList counts;
+    for (int t = 0; t < CaseData::TableCount; ++t)
+        counts << QString("%1 %2").arg(data.table(CaseData::Table(t)).rowCount()).arg(CaseData::tableKey(CaseData::Table(t)));
+    return counts.join(", ");
+}
+
+JobResult validateCase(const QString &casePath)
+{
+    CaseData data;
+    QString errorString;
+    if (!CaseFile::read(casePath, &data, &errorString))
+        return {false, errorString};
+    return {true, describe(data)};
+}
+
+JobResult convertCase(const Options &options, const QString &casePath)
+{
+    CaseData data;
+    QString errorString;
+    if (!CaseFile::read(casePath, &data, &errorString))
+        return {false, errorString};
+
+    // Without --format a case is converted to the other format
+    CaseFile::Format format = CaseBinaryFormat::isBinaryCaseFile(casePath) ? CaseFile::Json : CaseFile::Binary;
+    if (options.format == QLatin1String("json"))
+        format = CaseFile::Json;
+    else if (options.format == QLatin1String("binary"))
+        format = CaseFile::Binary;
+    const QString suffix = format == CaseFile::Binary ? CaseBinaryFormat::FileSuffix : QStringLiteral("osintcase");
+    const QString target = outputPath(options, casePath, QFileInfo(casePath).completeBaseName() + "." + suffix);
+    if (QFileInfo(target).absoluteFilePath() == QFileInfo(casePath).absoluteFilePath())
+        return {false, "Converting would overwrite the case itself; choose another --output-dir."};
+    if (!CaseFile::write(target, format, data, &errorString))
+        return {false, errorString};
+    return {true, "written to " + target};
+}
+
+JobResult exportCase(const Options &options, const QString &casePath)
+{
+    CaseData data;
+    QString errorString;
+    if (!CaseFile::read(casePath, &data, &errorString))
+        return {false, errorString};
+
+    QString suffix = options.dialect.delimiter == '\t' ? ".tsv" : ".csv";
+    if (options.dialect.gzip)
+        suffix += ".gz";
+    QList<CsvExporter::Target> targets;
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        const QString fileName = QFileInfo(casePath).completeBaseName() + "_" + CaseData::tableKey(CaseData::Table(t)) + suffix;
+        targets.append({outputPath(options, casePath, fileName), data.table(CaseData::Table(t))});
+    }
+    // The exporter formats its chunks on the global pool, apart from the batch jobs
+    CsvExporter exporter(targets, options.dialect);
+    exporter.start();
+    exporter.wait();
+    if (exporter.result() != CsvExporter::Exported)
+        return {false, exporter.errorString()};
+    return {true, QString("%1 tables exported").arg(targets.size())};
+}
+
+JobResult mergeCases(const Options &options, const QStringList &casePaths)
+{
+    CaseMerger merger(casePaths, options.output, options.merge);
+    merger.start();
+    merger.wait();
+    if (merger.result() != CaseMerger::Merged)
+        return {false, merger.errorString()};
+    QString message = QString("merged %1 of %2 rows into %3").arg(merger.rowsMerged()).arg(merger.rowsRead()).arg(options.output);
+    if (merger.conflictCount() > 0)
+        message += QString("; %1 conflicts listed in %2").arg(merger.conflictCount()).arg(merger.reportPath());
+    return {true, message};
+}
+
+void print(FILE *stream, const QString &text)
+{
+    fprintf(stream, "%s\n", qPrintable(text));
+    fflush(stream);
+}
+
+} // namespace
+
+int CaseBatch::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Processes case files without a window.\n\n"
+        "Commands:\n"
+        "  validate  Read each case, with its journal, and report its table sizes.\n"
+        "  convert   Rewrite each case in the other format, or the one given by --format.\n"
+        "  export    Write every table of each case as a CSV file.\n"
+        "  merge     Combine the cases into the --output case, dropping duplicate rows.\n"
+        "            Rows that share a key but differ are listed in <output>_conflicts.csv.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "validate, convert, export or merge.");
+    parser.addPositionalArgument("cases", "The case files to process.", "<case>...");
+    const QCommandLineOption batchOption("batch", "Run without a window. Required for the other options.");
+    const QCommandLineOption jobsOption({"j", "jobs"}, "Process <n> cases at a time (default: one per core).", "n");
+    const QCommandLineOption outputDirOption({"d", "output-dir"}, "Write converted cases and CSV files to <dir> (default: next to each case).", "dir");
+    const QCommandLineOption outputOption({"o", "output"}, "The case file merge writes.", "file");
+    const QCommandLineOption formatOption("format", "Format convert writes: json or binary.", "format");
+    const QCommandLineOption delimiterOption("delimiter", "CSV delimiter: comma, semicolon or tab (default: comma).", "delimiter");
+    const QCommandLineOption quoteMinimalOption("quote-minimal", "Quote only CSV fields that need it.");
+    const QCommandLineOption gzipOption("gzip", "Compress CSV files with gzip.");
+    const QCommandLineOption matchCaseOption("match-case", "Merge: tell entity names apart by letter case.");
+    const QCommandLineOption matchWhitespaceOption("match-whitespace", "Merge: tell entity names apart by spacing.");
+    parser.addOptions({batchOption, jobsOption, outputDirOption, outputOption, formatOption, delimiterOption,
+                       quoteMinimalOption, gzipOption, matchCaseOption, matchWhitespaceOption});
+
+    if (!parser.parse(arguments)) {
+        print(stderr, parser.errorText());
+        return 2;
+    }
+    if (parser.isSet("help")) {
+        print(stdout, parser.helpText());
+        return 0;
+    }
+
+    QStringList casePaths = parser.positionalArguments();
+    Options options;
+    options.command = casePaths.isEmpty() ? QString() : casePaths.takeFirst();
+    options.outputDirectory = parser.value(outputDirOption);
+    options.output = parser.value(outputOption);
+    options.format = parser.value(formatOption).toLower();
+    const QString delimiter = parser.value(delimiterOption).toLower();
+    options.dialect.delimiter = delimiter == "semicolon" || delimiter == ";" ? ';' : delimiter == "tab" ? '\t' : ',';
+    options.dialect.quoting = parser.isSet(quoteMinimalOption) ? CsvDialect::QuoteMinimal : CsvDialect::QuoteAll;
+    options.dialect.gzip = parser.isSet(gzipOption);
+    options.merge.foldCase = !parser.isSet(matchCaseOption);
+    options.merge.collapseWhitespace = !parser.isSet(matchWhitespaceOption);
+
+    const QStringList commands = {"validate", "convert", "export", "merge"};
+    if (!commands.contains(options.command) || casePaths.isEmpty()) {
+        print(stderr, "Usage: DataOrganizer --batch <validate|convert|export|merge> [options] <case>...\n"
+                      "Run with --batch --help for details.");
+        return 2;
+    }
+    if (!options.format.isEmpty() && options.format != "json" && options.format != "binary") {
+        print(stderr, "--format must be json or binary.");
+        return 2;
+    }
+    if (options.command == "merge" && options.output.isEmpty()) {
+        print(stderr, "merge needs --output.");
+        return 2;
+    }
+    if (options.dialect.gzip && !CsvExporter::isGzipSupported()) {
+        print(stderr, "This build cannot write gzip files.");
+        return 2;
+    }
+    if (!options.outputDirectory.isEmpty() && !QDir().mkpath(options.outputDirectory)) {
+        print(stderr, "Could not create " + options.outputDirectory);
+        return 1;
+    }
+
+    QThreadPool pool;
+    const int jobs = parser.value(jobsOption).toInt();
+    pool.setMaxThreadCount(jobs > 0 ? jobs : QThread::idealThreadCount());
+
+    if (options.command == "merge") {
+        const JobResult result = mergeCases(options, casePaths);
+        print(result.ok ? stdout : stderr, (result.ok ? "ok: " : "failed: ") + result.message);
+        return result.ok ? 0 : 1;
+    }
+
+    QMutex outputMutex;
+    std::atomic<int> failures{0};
+    for (const QString &casePath : std::as_const(casePaths)) {
+        pool.start([&options, casePath, &outputMutex, &failures]() {
+            JobResult result;
+            if (options.command == "validate")
+                result = validateCase(casePath);
+            else if (options.command == "convert")
+                result = convertCase(options, casePath);
+            else
+                result = exportCase(options, casePath);
+            if (!result.ok)
+                ++failures;
+            QMutexLocker locker(&outputMutex);
+            print(result.ok ? stdout : stderr, (result.ok ? "ok " : "failed ") + casePath + ": " + result.message);
+        });
+    }
+    pool.waitForDone();
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+#ifndef CASEBATCH_H
+#define CASEBATCH_H
+
+#include <QStringList>
+
+// Headless command line mode, started with --batch. Validates, converts,
+// exports and merges case files without creating any widgets, so it runs on
+// machines without a display. Case files are processed in parallel, one per
+// core unless --jobs says otherwise. Run with --batch --help for the commands.
+class CaseBatch
+{
+public:
+    // Returns the process exit code: 0 when every case was processed, 1 when
+    // some failed, 2 for a usage error.
+    static int run(const QStringList &arguments);
+};
+
+#endif // CASEBATCH_H
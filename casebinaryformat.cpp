@@ -0,0 +1,371 @@
+#include "casebinaryformat.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// PNG-style signature: the high byte and line ending catch text-mode transfers
+constexpr char Magic[8] = {'\x89', 'D', 'O', 'C', 'A', 'S', 'E', '\n'};
+constexpr quint32 FormatVersion = 1;
+constexpr qint64 HeaderSize = 64;
+constexpr qint64 DirectoryEntrySize = 32;
+constexpr qint64 ColumnEntrySize = 8;
+constexpr qint64 WriteBufferSize = 1024 * 1024;
+constexpr quint32 NoFileId = std::numeric_limits<quint32>::max();
+
+class MappedCaseFile : public StringPool::Source
+{
+public:
+    bool open(const QString &filePath, QString *errorString)
+    {
+        file.setFileName(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            *errorString = "Couldn't open case file: " + file.errorString();
+            return false;
+        }
+        size = file.size();
+        if (size < HeaderSize) {
+            *errorString = "Case file is truncated.";
+            return false;
+        }
+        data = file.map(0, size);
+        if (!data) {
+            *errorString = "Couldn't map case file: " + file.errorString();
+            return false;
+        }
+        // The mapping outlives the loading thread; QFile needs no event loop for it
+        file.moveToThread(nullptr);
+
+        if (memcmp(data, Magic, sizeof(Magic)) != 0) {
+            *errorString = "Not a binary case file.";
+            return false;
+        }
+        if (read<quint32>(8) != FormatVersion) {
+            *errorString = QString("Unsupported case file version %1.").arg(read<quint32>(8));
+            return false;
+        }
+        const quint64 strings = read<quint64>(16);
+        stringDataPos = qint64(read<quint64>(24));
+        stringOffsetsPos = qint64(read<quint64>(32));
+        if (strings == 0 || strings > NoFileId || !contains(stringOffsetsPos, qint64(strings + 1) * 8)
+            || !contains(stringDataPos, 0)) {
+            *errorString = "Case file string table is corrupt.";
+            return false;
+        }
+        stringCount = quint32(strings);
+        return true;
+    }
+
+    quint32 count() const override { return stringCount; }
+
+    QByteArrayView utf8(quint32 id) const override
+    {
+        if (id >= stringCount)
+            return QByteArrayView();
+        const quint64 begin = read<quint64>(stringOffsetsPos + qint64(id) * 8);
+        const quint64 end = read<quint64>(stringOffsetsPos + qint64(id + 1) * 8);
+        if (begin > end || end > quint64(size) || !contains(stringDataPos + qint64(begin), qint64(end - begin)))
+            return QByteArrayView();
+        return QByteArrayView(reinterpret_cast<const char *>(data + stringDataPos + begin), qsizetype(end - begin));
+    }
+
+#if defined(Q_OS_WIN)
+    // Windows cannot replace a file that is mapped, and saving the case usually
+    // writes over this very file. Once the records are read, only the string
+    // table is needed: keep a copy of it and close the file.
+    void release()
+    {
+        stringTable = QByteArray(reinterpret_cast<const char *>(data + stringDataPos), size - stringDataPos);
+        file.unmap(const_cast<uchar *>(data));
+        file.close();
+        data = reinterpret_cast<const uchar *>(stringTable.constData());
+        size = stringTable.size();
+        stringOffsetsPos -= stringDataPos;
+        stringDataPos = 0;
+    }
+#endif
+
+    template <typename T>
+    T read(qint64 pos) const { return qFromLittleEndian<T>(data + pos); }
+
+    bool contains(qint64 pos, qint64 length) const
+    {
+        return pos >= 0 && length >= 0 && pos <= size && length <= size - pos;
+    }
+
+    const uchar *data = nullptr;
+    qint64 size = 0;
+
+private:
+    QFile file;
+#if defined(Q_OS_WIN)
+    QByteArray stringTable;
+#endif
+    quint32 stringCount = 0;
+    qint64 stringDataPos = 0;
+    qint64 stringOffsetsPos = 0;
+};
+
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(QIODevice *device) : device(device) { buffer.reserve(WriteBufferSize); }
+
+    template <typename T>
+    void put(T value)
+    {
+        char bytes[sizeof(T)];
+        qToLittleEndian(value, bytes);
+        putBytes(bytes, sizeof(T));
+    }
+
+    void putBytes(const char *bytes, qsizetype length)
+    {
+        buffer.append(bytes, length);
+        written += length;
+        if (buffer.size() >= WriteBufferSize)
+            flush();
+    }
+
+    bool flush()
+    {
+        if (!buffer.isEmpty() && device->write(buffer) != buffer.size())
+            ok = false;
+        buffer.clear();
+        return ok;
+    }
+
+    qint64 pos() const { return written; }
+    bool isOk() const { return ok; }
+
+private:
+    QIODevice *device;
+    QByteArray buffer;
+    qint64 written = 0;
+    bool ok = true;
+};
+
+bool fail(QString *errorString, const QString &message)
+{
+    *errorString = message;
+    return false;
+}
+
+} // namespace
+
+const QString CaseBinaryFormat::FileSuffix = QStringLiteral("osintbin");
+
+bool CaseBinaryFormat::isBinaryCase(QByteArrayView head)
+{
+    return head.size() >= qsizetype(sizeof(Magic)) && memcmp(head.data(), Magic, sizeof(Magic)) == 0;
+}
+
+bool CaseBinaryFormat::isBinaryCaseFile(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) && isBinaryCase(file.read(sizeof(Magic)));
+}
+
+bool CaseBinaryFormat::read(const QString &filePath, CaseData *data, QString *errorString)
+{
+    const auto mapped = QSharedPointer<MappedCaseFile>::create();
+    if (!mapped->open(filePath, errorString))
+        return false;
+    const StringPool strings(mapped);
+    const quint32 stringCount = quint32(strings.count());
+
+    CaseData result;
+    const quint32 caseNameId = mapped->read<quint32>(40);
+    const quint32 subjectTargetId = mapped->read<quint32>(44);
+    const quint32 notesId = mapped->read<quint32>(48);
+    if (caseNameId >= stringCount || subjectTargetId >= stringCount || notesId >= stringCount)
+        return fail(errorString, "Case file header is corrupt.");
+    result.caseName = strings.at(caseNameId);
+    result.subjectTarget = strings.at(subjectTargetId);
+    result.notes = strings.at(notesId);
+
+    const quint32 tableCount = mapped->read<quint32>(12);
+    if (!mapped->contains(HeaderSize, qint64(tableCount) * DirectoryEntrySize))
+        return fail(errorString, "Case file table directory is corrupt.");
+
+    // Tables missing from an older file simply stay empty
+    for (int t = 0; t < CaseData::TableCount && quint32(t) < tableCount; ++t) {
+        const qint64 entry = HeaderSize + t * DirectoryEntrySize;
+        const quint32 rowCount = mapped->read<quint32>(entry);
+        const quint32 columnCount = mapped->read<quint32>(entry + 4);
+        const quint32 recordSize = mapped->read<quint32>(entry + 8);
+        const qint64 columnsPos = qint64(mapped->read<quint64>(entry + 16));
+        const qint64 recordsPos = qint64(mapped->read<quint64>(entry + 24));
+
+        const QList<CaseTable::Column> columns = CaseData::columns(CaseData::Table(t));
+        if (columnCount != quint32(columns.size()) || !mapped->contains(columnsPos, columnCount * ColumnEntrySize))
+            return fail(errorString, "Case file has an unsupported table layout.");
+
+        QList<qint64> cellOffsets;
+        qint64 expectedRecordSize = 0;
+        for (int c = 0; c < columns.size(); ++c) {
+            if (mapped->read<quint32>(columnsPos + c * ColumnEntrySize) != quint32(columns.at(c).type))
+                return fail(errorString, "Case file has an unsupported table layout.");
+            cellOffsets.append(expectedRecordSize);
+            expectedRecordSize += columns.at(c).type == CaseTable::Text ? 4 : 8;
+        }
+        if (recordSize != expectedRecordSize || rowCount > quint32(std::numeric_limits<int>::max())
+            || !mapped->contains(recordsPos, qint64(rowCount) * recordSize))
+            return fail(errorString, "Case file table records are corrupt.");
+
+        // Transpose the row records into columns in one sequential pass
+        QList<CaseTable::ColumnData> storage(columns.size());
+        QList<quint32 *> textOut(columns.size(), nullptr);
+        QList<qint64 *> valueOut(columns.size(), nullptr);
+        for (int c = 0; c < columns.size(); ++c) {
+            if (columns.at(c).type == CaseTable::Text) {
+                storage[c].text.resize(rowCount);
+                textOut[c] = storage[c].text.data();
+            } else {
+                storage[c].values.resize(rowCount);
+                valueOut[c] = storage[c].values.data();
+            }
+        }
+        const uchar *record = mapped->data + recordsPos;
+        for (quint32 r = 0; r < rowCount; ++r, record += recordSize) {
+            for (int c = 0; c < columns.size(); ++c) {
+                if (textOut.at(c)) {
+                    const quint32 id = qFromLittleEndian<quint32>(record + cellOffsets.at(c));
+                    textOut.at(c)[r] = id < stringCount ? id : 0;
+                } else {
+                    const qint64 value = qFromLittleEndian<qint64>(record + cellOffsets.at(c));
+                    valueOut.at(c)[r] = (value >= 0 || quint64(-(value + 1)) < stringCount) ? value : -1;
+                }
+            }
+        }
+        result.table(CaseData::Table(t)) = CaseTable(columns, strings, storage, int(rowCount));
+    }
+#if defined(Q_OS_WIN)
+    mapped->release();
+#endif
+
+    *data = result;
+    return true;
+}
+
+bool CaseBinaryFormat::write(const QString &filePath, const CaseData &data, QString *errorString)
+{
+    // QSaveFile writes a temporary file and renames it over the target, so a
+    // case that is still mapped from filePath stays readable while it is saved.
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return fail(errorString, "Could not open file for writing: " + file.errorString());
+    BufferedWriter out(&file);
+
+    // File string ids are handed out in order of first use across all tables
+    struct FileString {
+        const StringPool *pool;
+        quint32 id;
+        QString text;
+    };
+    QList<FileString> fileStrings;
+    fileStrings.append({nullptr, 0, QString()});
+    auto addText = [&fileStrings](const QString &text) -> quint32 {
+        if (text.isEmpty())
+            return 0;
+        fileStrings.append({nullptr, 0, text});
+        return quint32(fileStrings.size() - 1);
+    };
+
+    const quint32 caseNameId = addText(data.caseName);
+    const quint32 subjectTargetId = addText(data.subjectTarget);
+    const quint32 notesId = addText(data.notes);
+
+    const QByteArray placeholder(HeaderSize + CaseData::TableCount * DirectoryEntrySize, '\0');
+    out.putBytes(placeholder.constData(), placeholder.size());
+
+    qint64 columnsPos[CaseData::TableCount];
+    qint64 recordsPos[CaseData::TableCount];
+    quint32 recordSizes[CaseData::TableCount];
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        const CaseTable &table = data.table(CaseData::Table(t));
+        columnsPos[t] = out.pos();
+        recordSizes[t] = 0;
+        for (const CaseTable::Column &column : table.columns()) {
+            out.put<quint32>(column.type);
+            out.put<quint32>(addText(column.header));
+            recordSizes[t] += column.type == CaseTable::Text ? 4 : 8;
+        }
+    }
+
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        const CaseTable &table = data.table(CaseData::Table(t));
+        const StringPool &pool = table.stringPool();
+        QList<quint32> fileIds(pool.count(), NoFileId);
+        fileIds[0] = 0;
+        auto fileId = [&](quint32 id) {
+            if (fileIds.at(id) == NoFileId) {
+                fileIds[id] = quint32(fileStrings.size());
+                fileStrings.append({&pool, id, QString()});
+            }
+            return fileIds.at(id);
+        };
+
+        recordsPos[t] = out.pos();
+        for (int r = 0; r < table.rowCount(); ++r) {
+            for (int c = 0; c < table.columnCount(); ++c) {
+                const CaseTable::ColumnData &storage = table.columnStorage(c);
+                if (table.columns().at(c).type == CaseTable::Text) {
+                    out.put<quint32>(fileId(storage.text.at(r)));
+                } else {
+                    const qint64 value = storage.values.at(r);
+                    out.put<qint64>(value >= 0 ? value : -qint64(fileId(quint32(-(value + 1)))) - 1);
+                }
+            }
+        }
+        if (!out.isOk())
+            return fail(errorString, "Could not write case file: " + file.errorString());
+    }
+
+    const qint64 stringDataPos = out.pos();
+    QList<quint64> offsets;
+    offsets.reserve(fileStrings.size() + 1);
+    quint64 offset = 0;
+    for (const FileString &fileString : std::as_const(fileStrings)) {
+        const QByteArray utf8 = fileString.pool ? fileString.pool->toUtf8(fileString.id) : fileString.text.toUtf8();
+        offsets.append(offset);
+        out.putBytes(utf8.constData(), utf8.size());
+        offset += quint64(utf8.size());
+    }
+    offsets.append(offset);
+    const qint64 stringOffsetsPos = out.pos();
+    for (quint64 value : std::as_const(offsets))
+        out.put<quint64>(value);
+    if (!out.flush())
+        return fail(errorString, "Could not write case file: " + file.errorString());
+
+    // Fill in the header and directory now that every position is known
+    file.seek(0);
+    out.putBytes(Magic, sizeof(Magic));
+    out.put<quint32>(FormatVersion);
+    out.put<quint32>(CaseData::TableCount);
+    out.put<quint64>(quint64(fileStrings.size()));
+    out.put<quint64>(quint64(stringDataPos));
+    out.put<quint64>(quint64(stringOffsetsPos));
+    out.put<quint32>(caseNameId);
+    out.put<quint32>(subjectTargetId);
+    out.put<quint32>(notesId);
+    out.putBytes(placeholder.constData(), HeaderSize - 52);
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        const CaseTable &table = data.table(CaseData::Table(t));
+        out.put<quint32>(quint32(table.rowCount()));
+        out.put<quint32>(quint32(table.columnCount()));
+        out.put<quint32>(recordSizes[t]);
+        out.put<quint32>(0);
+        out.put<quint64>(quint64(columnsPos[t]));
+        out.put<quint64>(quint64(recordsPos[t]));
+    }
+    if (!out.flush() || !file.commit())
+        return fail(errorString, "Could not write case file: " + file.errorString());
+    return true;
+}
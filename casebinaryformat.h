@@ -0,0 +1,36 @@
+#ifndef CASEBINARYFORMAT_H
+#define CASEBINARYFORMAT_H
+
+#include "casedata.h"
+
+#include <QByteArrayView>
+#include <QString>
+
+// Versioned binary case file. Opening one maps the file into memory: the table
+// directory and fixed-width row records are copied into the column storage of
+// each table, while the string table is left in the mapping and strings are
+// decoded only when a cell is first shown or saved. On Windows, which cannot
+// save over a mapped file, the string table is copied out and the file closed.
+//
+// Layout (all integers little-endian):
+//   header     64 bytes   magic, version, table count, string table position,
+//                         string ids of case name, subject/target and notes
+//   directory  32 bytes per table: rows, columns, record size, column list
+//              position, record position
+//   columns    8 bytes per column: type, string id of the header
+//   records    rows x record size: 4-byte string id per text cell, 8-byte
+//              encoded time per time cell (see CaseTable::ColumnData)
+//   strings    UTF-8 string data, then (count + 1) 64-bit offsets into it
+class CaseBinaryFormat
+{
+public:
+    static const QString FileSuffix;
+
+    static bool isBinaryCase(QByteArrayView head);
+    static bool isBinaryCaseFile(const QString &filePath);
+
+    static bool read(const QString &filePath, CaseData *data, QString *errorString);
+    static bool write(const QString &filePath, const CaseData &data, QString *errorString);
+};
+
+#endif // CASEBINARYFORMAT_H
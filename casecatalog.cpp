@@ -0,0 +1,424 @@
+#include "casecatalog.h"
+#include "casedata.h"
+#include "casefile.h"
+#include "casejournal.h"
+#include "perftrace.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSaveFile>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace {
+
+constexpr quint32 IndexMagic = 0x444f4341; // "DOCA"
+constexpr quint32 IndexVersion = 1;
+// Changes usually come in bursts, such as a save or a copy of many files
+constexpr int UpdateDelay = 1000;
+constexpr int ProgressStep = 64;
+// Longer runs of letters and digits are hashes and encoded data, not names
+constexpr int MaxWordLength = 64;
+// Whole entity names are keyed apart from words; words never hold control characters
+constexpr QChar EntityNameKey = QChar(0x01);
+
+const QStringList CasePatterns = {QStringLiteral("*.osintcase"), QStringLiteral("*.osintbin")};
+
+struct Posting {
+    int file;
+    quint8 tables;
+};
+
+// What a case file looked like when it was read
+struct FileSignature {
+    qint64 size = -1;
+    qint64 modified = -1;
+    qint64 journalSize = -1;
+    qint64 journalModified = -1;
+
+    friend bool operator==(const FileSignature &a, const FileSignature &b)
+    {
+        return a.size == b.size && a.modified == b.modified && a.journalSize == b.journalSize
+            && a.journalModified == b.journalModified;
+    }
+};
+
+struct CatalogRecord {
+    FileSignature signature;
+    QString caseName;
+    QStringList entityNames; // words joined by single spaces
+    QStringList words;
+    QByteArray wordTables;   // CaseCatalog::TableFlags of each word
+};
+
+} // namespace
+
+struct CatalogIndex {
+    QString folder;
+    bool scanned = false; // false when only read back from disk
+    QHash<QString, CatalogRecord> records;
+    QStringList paths; // file ids of the postings
+    QHash<QString, QList<Posting>> postings;
+    QStringList directories;
+};
+
+namespace {
+
+QString indexPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/casecatalog");
+}
+
+// Case-folded runs of letters and digits
+QStringList catalogWords(QStringView text)
+{
+    QStringList words;
+    qsizetype start = -1;
+    for (qsizetype i = 0; i <= text.size(); ++i) {
+        const bool inWord = i < text.size() && (text[i].isLetterOrNumber() || text[i].isMark() || text[i].isSurrogate());
+        if (inWord && start < 0) {
+            start = i;
+        } else if (!inWord && start >= 0) {
+            if (i - start <= MaxWordLength)
+                words.append(text.mid(start, i - start).toString().toCaseFolded());
+            start = -1;
+        }
+    }
+    return words;
+}
+
+FileSignature fileSignature(const QFileInfo &info)
+{
+    FileSignature signature;
+    signature.size = info.size();
+    signature.modified = info.lastModified().toMSecsSinceEpoch();
+    const QFileInfo journal(CaseJournal::journalPath(info.filePath()));
+    if (journal.exists()) {
+        signature.journalSize = journal.size();
+        signature.journalModified = journal.lastModified().toMSecsSinceEpoch();
+    }
+    return signature;
+}
+
+// Every string in a table's pool is split into words once, however many cells hold it
+CatalogRecord readRecord(const QString &filePath)
+{
+    PERF_TRACE_SCOPE("catalog.readCase");
+    CatalogRecord record;
+    CaseData data;
+    QString errorString;
+    if (!CaseFile::read(filePath, &data, &errorString)) {
+        qWarning("Could not catalog %s: %s", qPrintable(filePath), qPrintable(errorString));
+        return record;
+    }
+    record.caseName = data.caseName;
+
+    QHash<QString, quint8> tablesOfWord;
+    QSet<QString> entityNames;
+    QByteArray buffer;
+    const std::pair<CaseData::Table, quint8> tables[] = {
+        {CaseData::Entities, CaseCatalog::InEntities},
+        {CaseData::Events, CaseCatalog::InEvents},
+        {CaseData::Resources, CaseCatalog::InResources},
+    };
+    for (const auto &[t, flag] : tables) {
+        const CaseTable &table = data.table(t);
+        const StringPool &strings = table.stringPool();
+        QList<bool> seen(strings.count());
+        for (int column = 0; column < table.columnCount(); ++column) {
+            if (table.columns().at(column).type != CaseTable::Text)
+                continue;
+            const bool isName = t == CaseData::Entities && column == 1;
+            QList<bool> seenName;
+            if (isName)
+                seenName.resize(strings.count());
+            for (const quint32 id : table.columnStorage(column).text) {
+                if (id == 0 || (seen.at(id) && (!isName || seenName.at(id))))
+                    continue;
+                const QStringList words = catalogWords(QString::fromUtf8(strings.utf8(id, buffer)));
+                if (!seen.at(id)) {
+                    seen[id] = true;
+                    for (const QString &word : words)
+                        tablesOfWord[word] |= flag;
+                }
+                if (isName && !seenName.at(id)) {
+                    seenName[id] = true;
+                    if (!words.isEmpty())
+                        entityNames.insert(words.join(u' '));
+                }
+            }
+        }
+    }
+
+    record.words.reserve(tablesOfWord.size());
+    record.wordTables.reserve(tablesOfWord.size());
+    for (auto it = tablesOfWord.cbegin(); it != tablesOfWord.cend(); ++it) {
+        record.words.append(it.key());
+        record.wordTables.append(char(it.value()));
+    }
+    record.entityNames = QStringList(entityNames.cbegin(), entityNames.cend());
+    return record;
+}
+
+void buildPostings(CatalogIndex *index)
+{
+    index->paths = index->records.keys();
+    std::sort(index->paths.begin(), index->paths.end());
+    index->postings.clear();
+    // Files are added in id order, so every list comes out sorted
+    for (int file = 0; file < index->paths.size(); ++file) {
+        const CatalogRecord &record = index->records[index->paths.at(file)];
+        for (int i = 0; i < record.words.size(); ++i)
+            index->postings[record.words.at(i)].append({file, quint8(record.wordTables.at(i))});
+        for (const QString &name : record.entityNames)
+            index->postings[EntityNameKey + name].append({file, quint8(CaseCatalog::InEntities)});
+    }
+}
+
+QSharedPointer<CatalogIndex> loadIndex(const QString &folder)
+{
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic, version, count;
+    QString indexedFolder;
+    stream >> magic >> version >> indexedFolder >> count;
+    if (stream.status() != QDataStream::Ok || magic != IndexMagic || version != IndexVersion || indexedFolder != folder)
+        return {};
+    auto index = QSharedPointer<CatalogIndex>::create();
+    index->folder = folder;
+    index->records.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        QString filePath;
+        CatalogRecord record;
+        FileSignature &signature = record.signature;
+        stream >> filePath >> signature.size >> signature.modified >> signature.journalSize >> signature.journalModified
+            >> record.caseName >> record.entityNames >> record.words >> record.wordTables;
+        if (stream.status() != QDataStream::Ok || record.words.size() != record.wordTables.size())
+            return {};
+        index->records.insert(filePath, record);
+    }
+    buildPostings(index.data());
+    return index;
+}
+
+void saveIndex(const CatalogIndex &index)
+{
+    QDir().mkpath(QFileInfo(indexPath()).path());
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << IndexMagic << IndexVersion << index.folder << quint32(index.records.size());
+    for (auto it = index.records.cbegin(); it != index.records.cend(); ++it) {
+        const CatalogRecord &record = it.value();
+        const FileSignature &signature = record.signature;
+        stream << it.key() << signature.size << signature.modified << signature.journalSize << signature.journalModified
+               << record.caseName << record.entityNames << record.words << record.wordTables;
+    }
+    if (stream.status() != QDataStream::Ok || !file.commit())
+        qWarning("Could not save the case catalog: %s", qPrintable(file.errorString()));
+}
+
+// Runs on a worker thread. Without an index for the folder yet, the one on
+// disk is returned as it is, to be scanned by the next call.
+QSharedPointer<const CatalogIndex> updateIndex(const QString &folder, QSharedPointer<const CatalogIndex> previous,
+                                               std::atomic<bool> *stop, CaseCatalog *catalog)
+{
+    PERF_TRACE_SCOPE("catalog.update");
+    if (!previous || previous->folder != folder) {
+        if (QSharedPointer<CatalogIndex> loaded = loadIndex(folder))
+            return loaded;
+        previous.reset();
+    }
+
+    struct Pending {
+        QString filePath;
+        FileSignature signature;
+        CatalogRecord record;
+    };
+    auto index = QSharedPointer<CatalogIndex>::create();
+    index->folder = folder;
+    index->scanned = true;
+    index->directories.append(folder);
+    QList<Pending> pending;
+    QDirIterator dirs(folder, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (dirs.hasNext())
+        index->directories.append(dirs.next());
+    QDirIterator files(folder, CasePatterns, QDir::Files, QDirIterator::Subdirectories);
+    while (files.hasNext()) {
+        files.next();
+        const QString filePath = files.filePath();
+        const FileSignature signature = fileSignature(files.fileInfo());
+        const auto known = previous ? previous->records.constFind(filePath) : QHash<QString, CatalogRecord>::const_iterator();
+        if (previous && known != previous->records.cend() && known->signature == signature)
+            index->records.insert(filePath, *known);
+        else
+            pending.append({filePath, signature, {}});
+        if (stop->load())
+            return {};
+    }
+
+    const int toRead = int(pending.size());
+    std::atomic<int> read{0};
+    emit catalog->progress(0, toRead);
+    QtConcurrent::blockingMap(pending, [&](Pending &file) {
+        if (stop->load())
+            return;
+        file.record = readRecord(file.filePath);
+        file.record.signature = file.signature;
+        const int done = ++read;
+        if (done % ProgressStep == 0 || done == toRead)
+            emit catalog->progress(done, toRead);
+    });
+    if (stop->load())
+        return {};
+    for (Pending &file : pending)
+        index->records.insert(file.filePath, std::move(file.record));
+
+    buildPostings(index.data());
+    if (!previous || !pending.isEmpty() || index->records.size() != previous->records.size())
+        saveIndex(*index);
+    return index;
+}
+
+} // namespace
+
+CaseCatalog::CaseCatalog(QObject *parent)
+    : QObject(parent)
+{
+    watcher = new QFutureWatcher<QSharedPointer<const CatalogIndex>>(this);
+    folderWatcher = new QFileSystemWatcher(this);
+    updateTimer = new QTimer(this);
+    updateTimer->setSingleShot(true);
+    updateTimer->setInterval(UpdateDelay);
+    connect(watcher, &QFutureWatcherBase::finished, this, &CaseCatalog::updateFinished);
+    connect(folderWatcher, &QFileSystemWatcher::directoryChanged, updateTimer, qOverload<>(&QTimer::start));
+    connect(updateTimer, &QTimer::timeout, this, &CaseCatalog::startUpdate);
+
+    // Not right away: reading the catalog has no business slowing down startup
+    catalogFolder = QSettings().value("catalog/folder").toString();
+    if (!catalogFolder.isEmpty())
+        updateTimer->start();
+}
+
+CaseCatalog::~CaseCatalog()
+{
+    stopRequested = true;
+    watcher->waitForFinished();
+}
+
+void CaseCatalog::setFolder(const QString &folder)
+{
+    const QString cleaned = folder.isEmpty() ? QString() : QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+    if (cleaned == catalogFolder)
+        return;
+    catalogFolder = cleaned;
+    QSettings().setValue("catalog/folder", cleaned);
+    index.reset();
+    if (!folderWatcher->directories().isEmpty())
+        folderWatcher->removePaths(folderWatcher->directories());
+    if (!cleaned.isEmpty())
+        startUpdate();
+}
+
+void CaseCatalog::caseChanged(const QString &filePath)
+{
+    if (!catalogFolder.isEmpty() && QDir::cleanPath(filePath).startsWith(catalogFolder + u'/'))
+        updateTimer->start();
+}
+
+int CaseCatalog::caseCount() const
+{
+    return index ? int(index->records.size()) : 0;
+}
+
+void CaseCatalog::startUpdate()
+{
+    if (catalogFolder.isEmpty())
+        return;
+    if (watcher->isRunning()) {
+        updatePending = true;
+        return;
+    }
+    updatePending = false;
+    watcher->setFuture(QtConcurrent::run(updateIndex, catalogFolder, index, &stopRequested, this));
+}
+
+void CaseCatalog::updateFinished()
+{
+    const QSharedPointer<const CatalogIndex> result = watcher->result();
+    // The folder may have changed meanwhile
+    if (result && result->folder == catalogFolder) {
+        index = result;
+        if (!result->scanned) {
+            // Read back from disk: usable now, brought up to date next
+            startUpdate();
+            return;
+        }
+        const QStringList watched = folderWatcher->directories();
+        if (QSet<QString>(watched.cbegin(), watched.cend()) != QSet<QString>(result->directories.cbegin(), result->directories.cend())) {
+            if (!watched.isEmpty())
+                folderWatcher->removePaths(watched);
+            folderWatcher->addPaths(result->directories);
+        }
+        emit updated(caseCount());
+    }
+    if (updatePending)
+        startUpdate();
+}
+
+// Intersects the lists of the words, rarest first
+QList<CatalogMatch> CaseCatalog::lookup(const QString &name) const
+{
+    PERF_TRACE_SCOPE("catalog.lookup");
+    const QStringList words = catalogWords(name);
+    if (!index || words.isEmpty())
+        return {};
+
+    QList<const QList<Posting> *> lists;
+    for (const QString &word : words) {
+        const auto it = index->postings.constFind(word);
+        if (it == index->postings.cend())
+            return {};
+        lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const QList<Posting> *a, const QList<Posting> *b) { return a->size() < b->size(); });
+    QList<Posting> found = *lists.first();
+    for (qsizetype l = 1; l < lists.size() && !found.isEmpty(); ++l) {
+        const QList<Posting> &other = *lists.at(l);
+        QList<Posting> both;
+        qsizetype j = 0;
+        for (const Posting &posting : std::as_const(found)) {
+            while (j < other.size() && other.at(j).file < posting.file)
+                ++j;
+            if (j < other.size() && other.at(j).file == posting.file)
+                both.append({posting.file, quint8(posting.tables | other.at(j).tables)});
+        }
+        found = both;
+    }
+
+    QSet<int> entityFiles;
+    for (const Posting &posting : index->postings.value(EntityNameKey + words.join(u' ')))
+        entityFiles.insert(posting.file);
+    QList<CatalogMatch> matches;
+    matches.reserve(found.size());
+    for (const Posting &posting : std::as_const(found)) {
+        const QString &filePath = index->paths.at(posting.file);
+        matches.append({filePath, index->records.constFind(filePath)->caseName, entityFiles.contains(posting.file), posting.tables});
+    }
+    std::stable_sort(matches.begin(), matches.end(), [](const CatalogMatch &a, const CatalogMatch &b) { return a.entity > b.entity; });
+    return matches;
+}
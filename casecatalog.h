@@ -0,0 +1,79 @@
+#ifndef CASECATALOG_H
+#define CASECATALOG_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include <atomic>
+
+class QFileSystemWatcher;
+class QTimer;
+struct CatalogIndex;
+
+// A catalogued case that mentions the name looked up.
+struct CatalogMatch
+{
+    QString filePath;
+    QString caseName;
+    bool entity = false; // one of the case's entities has exactly this name
+    int tables = 0;      // CaseCatalog::TableFlags of the tables the name's words appear in
+};
+
+// Index of the entities, events and resources of every case file under a
+// folder, so finding the cases that mention a name does not mean opening them.
+// Cell text is split into case-folded words, and the index maps each word, and
+// each whole entity name, to the cases holding it; a lookup intersects those
+// lists in memory.
+//
+// The index is kept on disk with the size and modification time of every case
+// and journal it was built from. Each update, on a worker thread, reads back
+// only the cases that changed since; the folder is watched and updated a
+// moment after files in it are added, replaced or removed.
+class CaseCatalog : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum TableFlag { InEntities = 1, InEvents = 2, InResources = 4 };
+
+    explicit CaseCatalog(QObject *parent = nullptr);
+    ~CaseCatalog();
+
+    QString folder() const { return catalogFolder; }
+    // Catalogs the case files under `folder`, or nothing for an empty path.
+    // Remembered between sessions.
+    void setFolder(const QString &folder);
+    // A case was saved. Journaled saves append to a file the watcher does not report.
+    void caseChanged(const QString &filePath);
+
+    // False until the index has been read or built for the first time.
+    bool isReady() const { return !index.isNull(); }
+    bool isUpdating() const { return watcher->isRunning(); }
+    int caseCount() const;
+
+    // Cases whose entities, events or resources hold every word of `name`,
+    // those with an entity of exactly that name first.
+    QList<CatalogMatch> lookup(const QString &name) const;
+
+signals:
+    void progress(int casesRead, int casesToRead);
+    // An update finished; the index now covers `caseCount` cases.
+    void updated(int caseCount);
+
+private slots:
+    void startUpdate();
+    void updateFinished();
+
+private:
+    QString catalogFolder;
+    QSharedPointer<const CatalogIndex> index;
+    QFutureWatcher<QSharedPointer<const CatalogIndex>> *watcher;
+    QFileSystemWatcher *folderWatcher;
+    QTimer *updateTimer;
+    std::atomic<bool> stopRequested{false};
+    bool updatePending = false;
+};
+
+#endif // CASECATALOG_H
@@ -0,0 +1,61 @@
+#include "casedata.h"
+
+CaseData::CaseData()
+    : entities(columns(Entities)), events(columns(Events)), resources(columns(Resources)), media(columns(Media)), hashes(columns(Hashes))
+{
+}
+
+CaseTable &CaseData::table(Table t)
+{
+    switch (t) {
+    case Events: return events;
+    case Resources: return resources;
+    case Media: return media;
+    case Hashes: return hashes;
+    default: return entities;
+    }
+}
+
+const CaseTable &CaseData::table(Table t) const
+{
+    return const_cast<CaseData *>(this)->table(t);
+}
+
+QList<CaseTable::Column> CaseData::columns(Table t)
+{
+    switch (t) {
+    case Entities:
+        return {{"Timestamp", CaseTable::MediaTime}, {"Entity Name"}, {"Type"}, {"Notes"}};
+    case Events:
+        return {{"Start Time", CaseTable::MediaTime}, {"End Time", CaseTable::MediaTime}, {"Event Description"}};
+    case Resources:
+        return {{"URL / File Path"}, {"Description"}, {"Date Accessed", CaseTable::DateTime}};
+    case Media:
+        return {{"File Path"}, {"Description"}};
+    case Hashes:
+        return {{"File Path"}, {"Size (bytes)"}, {"Modified", CaseTable::DateTime}, {"SHA-256"}};
+    default:
+        return {};
+    }
+}
+
+QString CaseData::tableKey(Table t)
+{
+    switch (t) {
+    case Entities: return QStringLiteral("entities");
+    case Events: return QStringLiteral("events");
+    case Resources: return QStringLiteral("resources");
+    case Media: return QStringLiteral("media");
+    case Hashes: return QStringLiteral("hashes");
+    default: return QString();
+    }
+}
+
+int CaseData::tableForKey(const QString &key)
+{
+    for (int t = 0; t < TableCount; ++t) {
+        if (key == tableKey(Table(t)))
+            return t;
+    }
+    return -1;
+}
@@ -0,0 +1,34 @@
+#ifndef CASEDATA_H
+#define CASEDATA_H
+
+#include "casetable.h"
+
+// Everything a case file holds. Built from implicitly shared parts, so taking a
+// copy of the open case is cheap.
+struct CaseData
+{
+    enum Table { Entities, Events, Resources, Media, Hashes, TableCount };
+
+    CaseData();
+
+    CaseTable &table(Table t);
+    const CaseTable &table(Table t) const;
+
+    // Column layout of each case table, as shown in the tabs and stored on disk.
+    static QList<CaseTable::Column> columns(Table t);
+    // Key of each table in the JSON case format.
+    static QString tableKey(Table t);
+    // The table stored under a JSON key, or -1.
+    static int tableForKey(const QString &key);
+
+    QString caseName;
+    QString subjectTarget;
+    QString notes;
+    CaseTable entities;
+    CaseTable events;
+    CaseTable resources;
+    CaseTable media; // video and image files referenced by the case
+    CaseTable hashes; // SHA-256 of the evidence files, as last checked
+};
+
+#endif // CASEDATA_H
@@ -0,0 +1,37 @@
+#include "casefile.h"
+#include "casebinaryformat.h"
+#include "casejournal.h"
+#include "casejsonformat.h"
+#include "perftrace.h"
+
+#include <QFileInfo>
+
+CaseFile::Format CaseFile::formatForPath(const QString &filePath)
+{
+    if (QFileInfo(filePath).suffix().compare(CaseBinaryFormat::FileSuffix, Qt::CaseInsensitive) == 0
+        || CaseBinaryFormat::isBinaryCaseFile(filePath))
+        return Binary;
+    return Json;
+}
+
+bool CaseFile::read(const QString &filePath, CaseData *data, QString *errorString)
+{
+    PERF_TRACE_SCOPE("case.read");
+    const bool read = CaseBinaryFormat::isBinaryCaseFile(filePath)
+        ? CaseBinaryFormat::read(filePath, data, errorString)
+        : CaseJsonFormat::read(filePath, data, errorString);
+    return read && CaseJournal::replay(filePath, data, errorString);
+}
+
+bool CaseFile::write(const QString &filePath, const CaseData &data, QString *errorString)
+{
+    return write(filePath, formatForPath(filePath), data, errorString);
+}
+
+bool CaseFile::write(const QString &filePath, Format format, const CaseData &data, QString *errorString)
+{
+    PERF_TRACE_SCOPE("case.write");
+    if (format == Binary)
+        return CaseBinaryFormat::write(filePath, data, errorString);
+    return CaseJsonFormat::write(filePath, data, errorString);
+}
@@ -0,0 +1,22 @@
+#ifndef CASEFILE_H
+#define CASEFILE_H
+
+#include "casedata.h"
+
+// Entry point for reading and writing a case without caring which on-disk
+// format it uses. Works without a GUI, for the window and for batch jobs alike.
+class CaseFile
+{
+public:
+    enum Format { Json, Binary };
+
+    // Binary when the suffix asks for it or when replacing a binary case,
+    // JSON otherwise.
+    static Format formatForPath(const QString &filePath);
+    // Reads the whole case on the calling thread, including any edits in its journal.
+    static bool read(const QString &filePath, CaseData *data, QString *errorString);
+    static bool write(const QString &filePath, const CaseData &data, QString *errorString);
+    static bool write(const QString &filePath, Format format, const CaseData &data, QString *errorString);
+};
+
+#endif // CASEFILE_H
@@ -0,0 +1,431 @@
+#include "casejournal.h"
+#include "perftrace.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <filesystem>
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char Magic[8] = {'\x89', 'D', 'O', 'J', 'R', 'N', 'L', '\n'};
+constexpr qint64 HeaderSize = 24;
+// A journal written while a compacted case replaces the old one: magic, the
+// compacted case, the old case, and where the edits made during compaction start
+constexpr char RebasedMagic[8] = {'\x89', 'D', 'O', 'J', 'R', 'N', 'R', '\n'};
+constexpr qint64 RebasedHeaderSize = 48;
+constexpr qint64 FrameHeaderSize = 6;
+// Past this many pending cells a full save is cheaper than journaling them
+constexpr qint64 MaxPendingCells = 1000000;
+// Past this much spliced-in text the notes are journaled whole instead
+constexpr qint64 MaxPendingNotesText = 4 * 1024 * 1024;
+
+// Size and modification time of a case file
+QByteArray caseVersion(const QString &casePath)
+{
+    const QFileInfo caseInfo(casePath);
+    QByteArray version(16, '\0');
+    qToLittleEndian<quint64>(quint64(caseInfo.size()), version.data());
+    qToLittleEndian<qint64>(caseInfo.lastModified().toMSecsSinceEpoch(), version.data() + 8);
+    return version;
+}
+
+QByteArray journalHeader(const QString &casePath)
+{
+    return QByteArray(Magic, sizeof(Magic)) + caseVersion(casePath);
+}
+
+// Position of the first edit that applies to the case as it is on disk, or -1
+// when the journal belongs to another version of it
+qint64 firstEdit(QFile &journal, const QString &casePath)
+{
+    if (!journal.seek(0))
+        return -1;
+    const QByteArray header = journal.read(RebasedHeaderSize);
+    const QByteArray version = caseVersion(casePath);
+    if (header.size() >= HeaderSize && header.startsWith(QByteArrayView(Magic, sizeof(Magic))))
+        return header.mid(8, 16) == version ? HeaderSize : -1;
+    if (header.size() < RebasedHeaderSize || !header.startsWith(QByteArrayView(RebasedMagic, sizeof(RebasedMagic))))
+        return -1;
+    // The compacted case already holds the edits before the offset; the old one does not
+    if (header.mid(8, 16) == version) {
+        const qint64 tail = qFromLittleEndian<qint64>(header.constData() + 40);
+        return tail >= RebasedHeaderSize && tail <= journal.size() ? tail : -1;
+    }
+    return header.mid(24, 16) == version ? RebasedHeaderSize : -1;
+}
+
+bool writeJournal(const QString &path, const QByteArray &bytes, QString *errorString)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() || !file.commit()) {
+        *errorString = "Could not rewrite journal: " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// Each record is framed by its length and a checksum, so a record torn by a
+// crash is detected and replay stops before it.
+void appendRecord(QByteArray &out, const CaseEdit &edit)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << quint8(edit.kind) << qint32(edit.target) << qint32(edit.row) << qint32(edit.column)
+           << qint32(edit.count) << edit.texts;
+
+    char frame[FrameHeaderSize];
+    qToLittleEndian<quint32>(quint32(payload.size()), frame);
+    qToLittleEndian<quint16>(qChecksum(payload), frame + 4);
+    out.append(frame, FrameHeaderSize);
+    out.append(payload);
+}
+
+bool syncToDisk(QFile &file)
+{
+#if defined(Q_OS_WIN)
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+} // namespace
+
+void CaseJournal::recordCell(int table, int row, int column, const QString &text)
+{
+    if (fullSaveRequired)
+        return;
+    // Typing into the same cell again only keeps the latest text
+    if (!pending.isEmpty()) {
+        CaseEdit &last = pending.last();
+        if (last.kind == CaseEdit::SetCell && last.target == table && last.row == row && last.column == column) {
+            last.texts = {text};
+            return;
+        }
+    }
+    CaseEdit edit;
+    edit.kind = CaseEdit::SetCell;
+    edit.target = table;
+    edit.row = row;
+    edit.column = column;
+    edit.texts = {text};
+    pending.append(edit);
+    if (++pendingCells > MaxPendingCells)
+        requireFullSave();
+}
+
+void CaseJournal::recordInsertedRows(int table, int row, int count, const CaseTable &contents)
+{
+    if (fullSaveRequired)
+        return;
+    pendingCells += qint64(count) * contents.columnCount();
+    if (pendingCells > MaxPendingCells) {
+        requireFullSave();
+        return;
+    }
+    CaseEdit edit;
+    edit.kind = CaseEdit::InsertRows;
+    edit.target = table;
+    edit.row = row;
+    edit.count = count;
+    edit.texts.reserve(count * contents.columnCount());
+    for (int r = row; r < row + count; ++r) {
+        for (int c = 0; c < contents.columnCount(); ++c)
+            edit.texts.append(contents.cell(r, c));
+    }
+    pending.append(edit);
+}
+
+void CaseJournal::recordRemovedRows(int table, int row, int count)
+{
+    if (fullSaveRequired)
+        return;
+    CaseEdit edit;
+    edit.kind = CaseEdit::RemoveRows;
+    edit.target = table;
+    edit.row = row;
+    edit.count = count;
+    pending.append(edit);
+}
+
+void CaseJournal::recordField(CaseEdit::Field field)
+{
+    dirtyFields[field] = true;
+}
+
+void CaseJournal::recordNotesEdit(int position, int removed, const QString &inserted)
+{
+    // Once the whole notes are due to be written, splices would be applied twice
+    if (fullSaveRequired || dirtyFields[CaseEdit::Notes])
+        return;
+    pendingNotesText += inserted.size();
+    if (pendingNotesText > MaxPendingNotesText) {
+        pending.removeIf([](const CaseEdit &edit) { return edit.kind == CaseEdit::SpliceNotes; });
+        pendingNotesText = 0;
+        recordField(CaseEdit::Notes);
+        return;
+    }
+
+    if (!pending.isEmpty() && pending.last().kind == CaseEdit::SpliceNotes) {
+        CaseEdit &last = pending.last();
+        QString &text = last.texts.first();
+        const int end = last.row + int(text.size());
+        if (removed == 0 && position == end) {
+            // Typing on at the end of the last splice
+            text += inserted;
+            return;
+        }
+        if (inserted.isEmpty() && position >= last.row && position + removed == end) {
+            // Backspacing over what the last splice put in
+            text.chop(removed);
+            return;
+        }
+    }
+    CaseEdit edit;
+    edit.kind = CaseEdit::SpliceNotes;
+    edit.target = CaseEdit::Notes;
+    edit.row = position;
+    edit.count = removed;
+    edit.texts = {inserted};
+    pending.append(edit);
+}
+
+void CaseJournal::requireFullSave()
+{
+    fullSaveRequired = true;
+    pending.clear();
+    pendingCells = 0;
+    pendingNotesText = 0;
+}
+
+void CaseJournal::reset()
+{
+    pending.clear();
+    pendingCells = 0;
+    pendingNotesText = 0;
+    std::fill(std::begin(dirtyFields), std::end(dirtyFields), false);
+    fullSaveRequired = false;
+}
+
+bool CaseJournal::canAppendTo(const QString &casePath) const
+{
+    if (fullSaveRequired || !QFileInfo::exists(casePath))
+        return false;
+    QFile journal(journalPath(casePath));
+    if (!journal.exists())
+        return true;
+    return journal.open(QIODevice::ReadOnly) && firstEdit(journal, casePath) >= 0;
+}
+
+bool CaseJournal::commit(const QString &casePath, const std::function<QString(CaseEdit::Field)> &fieldText,
+                         QString *errorString)
+{
+    PERF_TRACE_SCOPE("journal.commit");
+    QFile journal(journalPath(casePath));
+    if (!journal.open(QIODevice::ReadWrite)) {
+        *errorString = "Could not open journal: " + journal.errorString();
+        return false;
+    }
+    const qint64 originalSize = journal.size();
+
+    QByteArray bytes;
+    if (originalSize == 0)
+        bytes = journalHeader(casePath);
+    for (int f = 0; f < CaseEdit::FieldCount; ++f) {
+        if (!dirtyFields[f])
+            continue;
+        CaseEdit edit;
+        edit.kind = CaseEdit::SetField;
+        edit.target = f;
+        edit.texts = {fieldText(CaseEdit::Field(f))};
+        appendRecord(bytes, edit);
+    }
+    for (const CaseEdit &edit : std::as_const(pending))
+        appendRecord(bytes, edit);
+
+    if (!journal.seek(originalSize) || journal.write(bytes) != bytes.size() || !journal.flush()
+        || !syncToDisk(journal)) {
+        *errorString = "Could not write journal: " + journal.errorString();
+        // Never leave a partial record behind for the next append to follow
+        journal.resize(originalSize);
+        return false;
+    }
+    reset();
+    return true;
+}
+
+QString CaseJournal::journalPath(const QString &casePath)
+{
+    return casePath + QStringLiteral(".journal");
+}
+
+qint64 CaseJournal::journalSize(const QString &casePath)
+{
+    return QFileInfo(journalPath(casePath)).size();
+}
+
+bool CaseJournal::readEdits(const QString &casePath, QList<CaseEdit> *edits, QString *errorString)
+{
+    QFile journal(journalPath(casePath));
+    if (!journal.exists())
+        return true;
+    if (!journal.open(QIODevice::ReadOnly)) {
+        *errorString = "Could not open journal: " + journal.errorString();
+        return false;
+    }
+    const qint64 start = firstEdit(journal, casePath);
+    if (start < 0 || !journal.seek(start)) {
+        *errorString = "The journal " + journal.fileName() + " belongs to a different version of the case and was ignored.";
+        return false;
+    }
+
+    for (;;) {
+        const QByteArray frame = journal.read(FrameHeaderSize);
+        if (frame.size() < FrameHeaderSize)
+            break;
+        const quint32 length = qFromLittleEndian<quint32>(frame.constData());
+        const quint16 checksum = qFromLittleEndian<quint16>(frame.constData() + 4);
+        if (qint64(length) > journal.bytesAvailable())
+            break;
+        const QByteArray payload = journal.read(length);
+        if (payload.size() < qsizetype(length) || qChecksum(payload) != checksum)
+            break;
+
+        QDataStream stream(payload);
+        stream.setVersion(QDataStream::Qt_6_0);
+        quint8 kind;
+        qint32 target, row, column, count;
+        CaseEdit edit;
+        stream >> kind >> target >> row >> column >> count >> edit.texts;
+        if (stream.status() != QDataStream::Ok || kind > CaseEdit::SpliceNotes)
+            break;
+        edit.kind = CaseEdit::Kind(kind);
+        edit.target = target;
+        edit.row = row;
+        edit.column = column;
+        edit.count = count;
+        edits->append(edit);
+    }
+    return true;
+}
+
+void CaseJournal::apply(const CaseEdit &edit, CaseData *data)
+{
+    if (edit.kind == CaseEdit::SetField) {
+        const QString text = edit.texts.value(0);
+        switch (edit.target) {
+        case CaseEdit::CaseName: data->caseName = text; break;
+        case CaseEdit::SubjectTarget: data->subjectTarget = text; break;
+        case CaseEdit::Notes: data->notes = text; break;
+        }
+        return;
+    }
+    if (edit.kind == CaseEdit::SpliceNotes) {
+        if (edit.row >= 0 && edit.count >= 0 && edit.row + edit.count <= data->notes.size())
+            data->notes.replace(edit.row, edit.count, edit.texts.value(0));
+        return;
+    }
+    if (edit.target < 0 || edit.target >= CaseData::TableCount)
+        return;
+
+    CaseTable &table = data->table(CaseData::Table(edit.target));
+    const int columns = table.columnCount();
+    switch (edit.kind) {
+    case CaseEdit::SetCell:
+        if (edit.row >= 0 && edit.row < table.rowCount() && edit.column >= 0 && edit.column < columns)
+            table.setCell(edit.row, edit.column, edit.texts.value(0));
+        break;
+    case CaseEdit::InsertRows:
+        if (edit.row >= 0 && edit.row <= table.rowCount() && edit.count > 0) {
+            table.insertRows(edit.row, edit.count);
+            for (int r = 0; r < edit.count; ++r) {
+                for (int c = 0; c < columns; ++c)
+                    table.setCell(edit.row + r, c, edit.texts.value(r * columns + c));
+            }
+        }
+        break;
+    case CaseEdit::RemoveRows:
+        if (edit.row >= 0 && edit.count > 0 && edit.row + edit.count <= table.rowCount())
+            table.removeRows(edit.row, edit.count);
+        break;
+    default:
+        break;
+    }
+}
+
+bool CaseJournal::replay(const QString &casePath, CaseData *data, QString *errorString)
+{
+    QList<CaseEdit> edits;
+    if (!readEdits(casePath, &edits, errorString))
+        return false;
+    for (const CaseEdit &edit : std::as_const(edits))
+        apply(edit, data);
+    return true;
+}
+
+void CaseJournal::discard(const QString &casePath)
+{
+    QFile::remove(journalPath(casePath));
+}
+
+QString CaseJournal::compactionPath(const QString &casePath)
+{
+    return casePath + QStringLiteral(".compacting");
+}
+
+bool CaseJournal::rebase(const QString &casePath, qint64 replayedBytes, QString *errorString)
+{
+    const QString compactedPath = compactionPath(casePath);
+    QByteArray compacted; // edits the compacted case already holds
+    QByteArray tail;      // edits made while it was written
+    QFile journal(journalPath(casePath));
+    if (journal.open(QIODevice::ReadOnly)) {
+        const qint64 start = firstEdit(journal, casePath);
+        if (start >= 0 && replayedBytes >= start) {
+            journal.seek(start);
+            compacted = journal.read(replayedBytes - start);
+            tail = journal.readAll();
+        }
+        journal.close();
+    }
+
+    // Until the rename, the journal must still extend the old case; right after
+    // it, the new one. A journal tied to both holds for either.
+    if (!compacted.isEmpty() || !tail.isEmpty()) {
+        QByteArray header(RebasedMagic, sizeof(RebasedMagic));
+        header += caseVersion(compactedPath) + caseVersion(casePath);
+        header.resize(RebasedHeaderSize);
+        qToLittleEndian<qint64>(RebasedHeaderSize + compacted.size(), header.data() + 40);
+        if (!writeJournal(journalPath(casePath), header + compacted + tail, errorString)) {
+            QFile::remove(compactedPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(QFileInfo(compactedPath).filesystemFilePath(), QFileInfo(casePath).filesystemFilePath(), error);
+    if (error) {
+        QFile::remove(compactedPath);
+        *errorString = "Could not replace the case file: " + QString::fromStdString(error.message());
+        return false;
+    }
+
+    if (tail.isEmpty()) {
+        discard(casePath);
+        return true;
+    }
+    return writeJournal(journalPath(casePath), journalHeader(casePath) + tail, errorString);
+}
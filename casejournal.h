@@ -0,0 +1,70 @@
+#ifndef CASEJOURNAL_H
+#define CASEJOURNAL_H
+
+#include "casedata.h"
+
+#include <functional>
+
+// One change to an open case, in the order it was made.
+struct CaseEdit
+{
+    enum Kind : quint8 { SetField, SetCell, InsertRows, RemoveRows, SpliceNotes };
+    enum Field { CaseName, SubjectTarget, Notes, FieldCount };
+
+    Kind kind = SetCell;
+    int target = 0;    // the CaseData::Table, or the Field of a SetField edit
+    int row = 0;       // first row, or the notes position of a splice
+    int column = 0;
+    int count = 0;     // rows inserted or removed, or notes characters replaced by a splice
+    QStringList texts; // field or cell text, the row-major cells of inserted rows, or the spliced-in notes
+};
+
+// Write-ahead journal for incremental saves. Edits made since the last save are
+// collected in memory and a save appends just those to "<case>.journal", so its
+// cost follows the size of the edit rather than the size of the case. Opening a
+// case replays its journal. The journal records the size and modification time
+// of the case file it extends and is ignored if that file has been replaced.
+class CaseJournal
+{
+public:
+    void recordCell(int table, int row, int column, const QString &text);
+    void recordInsertedRows(int table, int row, int count, const CaseTable &contents);
+    void recordRemovedRows(int table, int row, int count);
+    void recordField(CaseEdit::Field field);
+    // Keeps only the changed range of the notes; typing is folded into one splice.
+    void recordNotesEdit(int position, int removed, const QString &inserted);
+    // For changes too large or too global to journal (reloading, bulk inserts).
+    void requireFullSave();
+    // The case on disk matches the open case again.
+    void reset();
+
+    bool canAppendTo(const QString &casePath) const;
+    // Field values are fetched only for fields that changed, at commit time.
+    bool commit(const QString &casePath, const std::function<QString(CaseEdit::Field)> &fieldText,
+                QString *errorString);
+
+    static QString journalPath(const QString &casePath);
+    static qint64 journalSize(const QString &casePath);
+    static bool readEdits(const QString &casePath, QList<CaseEdit> *edits, QString *errorString);
+    // Edits that do not fit the case (rows out of range) are skipped.
+    static void apply(const CaseEdit &edit, CaseData *data);
+    // Reads the journal of the case, if there is one, and applies it to `data`.
+    static bool replay(const QString &casePath, CaseData *data, QString *errorString);
+    static void discard(const QString &casePath);
+    // Where a compaction writes the new case file before it replaces the old one.
+    static QString compactionPath(const QString &casePath);
+    // The case was rewritten to compactionPath() from the state after the first
+    // `replayedBytes` of the journal: replaces the case file with it and keeps
+    // only the edits after that, tied to the new file. A crash at any point
+    // leaves a journal that replays onto whichever case file is on disk.
+    static bool rebase(const QString &casePath, qint64 replayedBytes, QString *errorString);
+
+private:
+    QList<CaseEdit> pending;
+    bool dirtyFields[CaseEdit::FieldCount] = {};
+    qint64 pendingCells = 0;
+    qint64 pendingNotesText = 0;
+    bool fullSaveRequired = false;
+};
+
+#endif // CASEJOURNAL_H
@@ -0,0 +1,178 @@
+#include "casejsonformat.h"
+
+#include <QFile>
+#include <QSaveFile>
+
+namespace {
+
+constexpr qsizetype WriteBufferSize = 1024 * 1024;
+constexpr int ReadBatchRows = 4096;
+
+void appendJsonString(QByteArray &out, const QString &text)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    const QByteArray utf8 = text.toUtf8();
+    const char *data = utf8.constData();
+    const qsizetype size = utf8.size();
+
+    out.append('"');
+    qsizetype runStart = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        const uchar c = uchar(data[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(data + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        case '\b': out.append("\\b"); break;
+        case '\f': out.append("\\f"); break;
+        default:
+            out.append("\\u00");
+            out.append(hexDigits[c >> 4]);
+            out.append(hexDigits[c & 0xF]);
+            break;
+        }
+    }
+    out.append(data + runStart, size - runStart);
+    out.append('"');
+}
+
+} // namespace
+
+bool CaseJsonFormat::read(const QString &filePath, CaseData *data, QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorString = "Couldn't open case file: " + file.errorString();
+        return false;
+    }
+    JsonStreamReader reader(&file);
+    if (reader.next() != JsonStreamReader::BeginObject) {
+        *errorString = QStringLiteral("Invalid JSON in case file.");
+        return false;
+    }
+
+    CaseData result;
+    for (;;) {
+        JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::EndObject)
+            break;
+        if (token != JsonStreamReader::String) {
+            *errorString = "Invalid JSON in case file. " + reader.errorString();
+            return false;
+        }
+        const QString key = reader.stringValue();
+        token = reader.next();
+
+        const int table = CaseData::tableForKey(key);
+        if (table >= 0 && token == JsonStreamReader::BeginArray) {
+            // Rows are added in batches to keep the string list short
+            CaseTable &contents = result.table(CaseData::Table(table));
+            QStringList cells;
+            while ((token = reader.next()) != JsonStreamReader::EndArray) {
+                if (!readRow(reader, token, contents.columnCount(), &cells)) {
+                    *errorString = "Invalid JSON in case file. " + reader.errorString();
+                    return false;
+                }
+                if (cells.size() >= ReadBatchRows * contents.columnCount()) {
+                    contents.appendRows(cells);
+                    cells.clear();
+                }
+            }
+            contents.appendRows(cells);
+        } else if (token == JsonStreamReader::String && key == QLatin1String("caseName")) {
+            result.caseName = reader.stringValue();
+        } else if (token == JsonStreamReader::String && key == QLatin1String("subjectTarget")) {
+            result.subjectTarget = reader.stringValue();
+        } else if (token == JsonStreamReader::String && key == QLatin1String("notes")) {
+            result.notes = reader.stringValue();
+        } else if (!reader.skipValue(token)) {
+            *errorString = "Invalid JSON in case file. " + reader.errorString();
+            return false;
+        }
+    }
+    *data = result;
+    return true;
+}
+
+bool CaseJsonFormat::readRow(JsonStreamReader &reader, JsonStreamReader::Token first, int columns, QStringList *cells)
+{
+    int column = 0;
+    if (first == JsonStreamReader::BeginArray) {
+        JsonStreamReader::Token token;
+        while ((token = reader.next()) != JsonStreamReader::EndArray) {
+            if (token == JsonStreamReader::String) {
+                if (column < columns)
+                    cells->append(reader.stringValue());
+            } else if (reader.skipValue(token)) {
+                if (column < columns)
+                    cells->append(QString());
+            } else {
+                return false;
+            }
+            ++column;
+        }
+    } else if (!reader.skipValue(first)) {
+        return false;
+    }
+    for (; column < columns; ++column)
+        cells->append(QString());
+    return true;
+}
+
+bool CaseJsonFormat::write(const QString &filePath, const CaseData &data, QString *errorString)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorString = "Could not open file for writing: " + file.errorString();
+        return false;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(WriteBufferSize + 4096);
+    auto flush = [&file, &buffer]() {
+        const bool ok = file.write(buffer) == buffer.size();
+        buffer.clear();
+        return ok;
+    };
+
+    buffer.append("{\n    \"caseName\": ");
+    appendJsonString(buffer, data.caseName);
+    buffer.append(",\n    \"subjectTarget\": ");
+    appendJsonString(buffer, data.subjectTarget);
+    buffer.append(",\n    \"notes\": ");
+    appendJsonString(buffer, data.notes);
+
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        const CaseTable &table = data.table(CaseData::Table(t));
+        buffer.append(",\n    ");
+        appendJsonString(buffer, CaseData::tableKey(CaseData::Table(t)));
+        buffer.append(": [");
+        for (int row = 0; row < table.rowCount(); ++row) {
+            buffer.append(row == 0 ? "\n        [" : ",\n        [");
+            for (int col = 0; col < table.columnCount(); ++col) {
+                if (col > 0)
+                    buffer.append(", ");
+                appendJsonString(buffer, table.cell(row, col));
+            }
+            buffer.append(']');
+            if (buffer.size() >= WriteBufferSize && !flush()) {
+                *errorString = "Could not write case file: " + file.errorString();
+                return false;
+            }
+        }
+        buffer.append(table.rowCount() > 0 ? "\n    ]" : "]");
+    }
+    buffer.append("\n}\n");
+
+    if (!flush() || !file.commit()) {
+        *errorString = "Could not write case file: " + file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef CASEJSONFORMAT_H
+#define CASEJSONFORMAT_H
+
+#include "casedata.h"
+#include "jsonstreamreader.h"
+
+// The original .osintcase layout: one JSON object holding the case fields and
+// each table as an array of rows, every row an array of cell strings.
+// The GUI reads it incrementally through CaseLoader; read() is for callers
+// that want the whole case at once. Both use JsonStreamReader.
+class CaseJsonFormat
+{
+public:
+    static bool read(const QString &filePath, CaseData *data, QString *errorString);
+    // Appends the `columns` cells of the row whose first token is `first`.
+    // Anything that is not an array of strings still yields a row, with blank
+    // cells where the values did not fit. False on malformed JSON.
+    static bool readRow(JsonStreamReader &reader, JsonStreamReader::Token first, int columns, QStringList *cells);
+    // Streams the case out through a buffer instead of building a QJsonDocument.
+    static bool write(const QString &filePath, const CaseData &data, QString *errorString);
+};
+
+#endif // CASEJSONFORMAT_H
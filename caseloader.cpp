@@ -0,0 +1,133 @@
+#include "caseloader.h"
+#include "casebinaryformat.h"
+#include "casejsonformat.h"
+#include "perftrace.h"
+
+#include <QFile>
+
+namespace {
+
+constexpr int BatchRows = 4096;
+constexpr int BatchesInFlight = 4;
+
+int columnCount(int table)
+{
+    return int(CaseData::columns(CaseData::Table(table)).size());
+}
+
+} // namespace
+
+CaseLoader::CaseLoader(const QString &filePath, QObject *parent)
+    : QThread(parent), filePath(filePath), batchSlots(BatchesInFlight)
+{
+}
+
+void CaseLoader::run()
+{
+    PERF_TRACE_SCOPE("case.load");
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail(QStringLiteral("Couldn't open load file: ") + file.errorString());
+        return;
+    }
+    totalBytes = file.size();
+    if (CaseBinaryFormat::isBinaryCase(file.peek(16))) {
+        file.close();
+        readBinary();
+        return;
+    }
+
+    JsonStreamReader reader(&file);
+    if (reader.next() != JsonStreamReader::BeginObject) {
+        fail(QStringLiteral("Invalid JSON in case file."));
+        return;
+    }
+
+    for (;;) {
+        if (isInterruptionRequested())
+            return;
+
+        JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::EndObject)
+            break;
+        if (token != JsonStreamReader::String) {
+            fail(QStringLiteral("Invalid JSON in case file. ") + reader.errorString());
+            return;
+        }
+        const QString key = reader.stringValue();
+        token = reader.next();
+
+        const int table = CaseData::tableForKey(key);
+        if (table >= 0 && token == JsonStreamReader::BeginArray) {
+            if (!readTable(reader, table))
+                return;
+        } else if (token == JsonStreamReader::String
+                   && (key == QLatin1String("caseName") || key == QLatin1String("subjectTarget")
+                       || key == QLatin1String("notes"))) {
+            emit fieldLoaded(key, reader.stringValue());
+        } else if (!reader.skipValue(token)) {
+            fail(QStringLiteral("Invalid JSON in case file. ") + reader.errorString());
+            return;
+        }
+        emit progress(reader.bytesConsumed(), totalBytes);
+    }
+
+    loadResult = Loaded;
+}
+
+void CaseLoader::readBinary()
+{
+    binary = true;
+    CaseData data;
+    if (!CaseBinaryFormat::read(filePath, &data, &error)) {
+        loadResult = Failed;
+        return;
+    }
+    emit fieldLoaded(QStringLiteral("caseName"), data.caseName);
+    emit fieldLoaded(QStringLiteral("subjectTarget"), data.subjectTarget);
+    emit fieldLoaded(QStringLiteral("notes"), data.notes);
+    for (int t = 0; t < CaseData::TableCount; ++t)
+        emit tableLoaded(t, data.table(CaseData::Table(t)));
+    emit progress(totalBytes, totalBytes);
+    loadResult = Loaded;
+}
+
+bool CaseLoader::readTable(JsonStreamReader &reader, int table)
+{
+    const int columns = columnCount(table);
+    QStringList cells;
+    cells.reserve(BatchRows * columns);
+
+    for (;;) {
+        const JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::EndArray)
+            break;
+        if (!CaseJsonFormat::readRow(reader, token, columns, &cells))
+            return fail(QStringLiteral("Invalid JSON in case file. ") + reader.errorString());
+
+        if (cells.size() >= BatchRows * columns && !deliver(reader, table, cells))
+            return false;
+    }
+    return cells.isEmpty() || deliver(reader, table, cells);
+}
+
+bool CaseLoader::deliver(JsonStreamReader &reader, int table, QStringList &cells)
+{
+    // Wait for the GUI to take an earlier batch before producing more
+    while (!batchSlots.tryAcquire(1, 50)) {
+        if (isInterruptionRequested())
+            return false;
+    }
+    emit rowsLoaded(table, cells);
+    emit progress(reader.bytesConsumed(), totalBytes);
+    cells = QStringList();
+    cells.reserve(BatchRows * columnCount(table));
+    return !isInterruptionRequested();
+}
+
+bool CaseLoader::fail(const QString &message)
+{
+    loadResult = Failed;
+    error = message;
+    return false;
+}
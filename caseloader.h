@@ -0,0 +1,56 @@
+#ifndef CASELOADER_H
+#define CASELOADER_H
+
+#include "casedata.h"
+
+#include <QSemaphore>
+#include <QStringList>
+#include <QThread>
+
+class JsonStreamReader;
+
+// Reads a case file on its own thread. JSON cases are streamed and their rows
+// handed to the GUI in batches; at most a few batches are in flight at once, so
+// memory stays bounded no matter how far the parser runs ahead of the models.
+// Binary cases are mapped and delivered as whole tables.
+// Cancel with requestInterruption(); result() is valid once finished() is emitted.
+class CaseLoader : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Result { Loaded, Failed, Cancelled };
+
+    explicit CaseLoader(const QString &filePath, QObject *parent = nullptr);
+
+    Result result() const { return loadResult; }
+    QString errorString() const { return error; }
+    bool isBinary() const { return binary; }
+
+    // Called by the receiver of rowsLoaded() once it has taken a batch.
+    void releaseBatch() { batchSlots.release(); }
+
+signals:
+    void fieldLoaded(const QString &key, const QString &value);
+    void rowsLoaded(int table, const QStringList &cells);
+    void tableLoaded(int table, const CaseTable &contents);
+    void progress(qint64 bytesRead, qint64 totalBytes);
+
+protected:
+    void run() override;
+
+private:
+    void readBinary();
+    bool readTable(JsonStreamReader &reader, int table);
+    bool deliver(JsonStreamReader &reader, int table, QStringList &cells);
+    bool fail(const QString &message);
+
+    const QString filePath;
+    QSemaphore batchSlots;
+    qint64 totalBytes = 0;
+    bool binary = false;
+    Result loadResult = Cancelled;
+    QString error;
+};
+
+#endif // CASELOADER_H
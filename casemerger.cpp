@@ -0,0 +1,211 @@
+#include "casemerger.h"
+#include "casefile.h"
+#include "csvexporter.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+namespace {
+
+constexpr int AppendBatchRows = 4096;
+constexpr int CancelCheckRows = 65536;
+// Past this many the report keeps counting but stops listing
+constexpr int MaxReportedConflicts = 100000;
+constexpr size_t SecondKeySeed = size_t(0x9e3779b97f4a7c15ULL);
+constexpr QChar CellSeparator = QChar(0x1f);
+
+// Which columns make two rows of a table the same row, and which of the
+// others are worth reporting when they differ.
+struct TableKey {
+    QList<int> keyColumns;
+    QList<int> normalizedColumns;
+    QList<int> payloadColumns;
+};
+
+TableKey tableKey(CaseData::Table t)
+{
+    switch (t) {
+    case CaseData::Entities: return {{0, 1, 2}, {1, 2}, {3}};
+    case CaseData::Events: return {{0, 1, 2}, {}, {}};
+    case CaseData::Resources: return {{0}, {}, {1}};
+    case CaseData::Media: return {{0}, {}, {1}};
+    case CaseData::Hashes: return {{0}, {}, {3}};
+    default: return {};
+    }
+}
+
+QList<CaseTable::Column> reportColumns()
+{
+    return {{"Table"}, {"Key"}, {"Column"}, {"Kept Value"}, {"Kept From"}, {"Other Value"}, {"Other From"}};
+}
+
+} // namespace
+
+CaseMerger::CaseMerger(const QStringList &casePaths, const QString &outputPath, const MergeOptions &options,
+                       QObject *parent)
+    : QThread(parent), casePaths(casePaths), outputPath(outputPath), options(options)
+{
+}
+
+QString CaseMerger::reportPathFor(const QString &outputPath)
+{
+    const QFileInfo info(outputPath);
+    return info.dir().filePath(info.completeBaseName() + "_conflicts.csv");
+}
+
+void CaseMerger::run()
+{
+    if (casePaths.isEmpty()) {
+        fail(QStringLiteral("No cases to merge."));
+        return;
+    }
+    report = CaseTable(reportColumns());
+
+    struct Source {
+        CaseData data;
+        QString error;
+        bool ok = false;
+    };
+    auto readCase = [](const QString &casePath) {
+        Source source;
+        source.ok = CaseFile::read(casePath, &source.data, &source.error);
+        return source;
+    };
+
+    QStringList subjects;
+    QStringList notes;
+    QFuture<Source> next = QtConcurrent::run(readCase, casePaths.first());
+    for (int i = 0; i < casePaths.size(); ++i) {
+        const Source source = next.result();
+        if (i + 1 < casePaths.size())
+            next = QtConcurrent::run(readCase, casePaths.at(i + 1));
+        if (isInterruptionRequested())
+            return;
+        if (!source.ok) {
+            fail(casePaths.at(i) + ": " + source.error);
+            return;
+        }
+
+        const CaseData &data = source.data;
+        if (merged.caseName.isEmpty())
+            merged.caseName = data.caseName;
+        if (!data.subjectTarget.isEmpty() && !subjects.contains(data.subjectTarget))
+            subjects << data.subjectTarget;
+        if (!data.notes.isEmpty())
+            notes << "--- " + QFileInfo(casePaths.at(i)).fileName() + " ---\n" + data.notes;
+        for (int t = 0; t < CaseData::TableCount; ++t) {
+            if (!mergeTable(CaseData::Table(t), data.table(CaseData::Table(t)), i))
+                return;
+        }
+        emit progress(i + 1, int(casePaths.size()));
+    }
+    merged.subjectTarget = subjects.join("; ");
+    merged.notes = notes.join("\n\n");
+
+    QString errorString;
+    if (!CaseFile::write(outputPath, merged, &errorString)) {
+        fail(errorString);
+        return;
+    }
+    const QString reportFile = reportPathFor(outputPath);
+    if (conflicts == 0) {
+        // A report from an earlier merge to the same file would be misleading
+        QFile::remove(reportFile);
+    } else {
+        CsvExporter exporter({{reportFile, report}}, CsvDialect());
+        exporter.start();
+        exporter.wait();
+        if (exporter.result() != CsvExporter::Exported) {
+            fail("Could not write the conflict report: " + exporter.errorString());
+            return;
+        }
+    }
+    mergeResult = Merged;
+}
+
+bool CaseMerger::mergeTable(CaseData::Table t, const CaseTable &source, int sourceIndex)
+{
+    const TableKey key = tableKey(t);
+    CaseTable &table = merged.table(t);
+    QHash<RowKey, KeptRow> &kept = keys[t];
+    const int columns = source.columnCount();
+    QStringList pending;
+    pending.reserve(qsizetype(AppendBatchRows) * columns);
+    auto flush = [&]() {
+        table.appendRows(pending);
+        pending.clear();
+    };
+
+    QString keyText;
+    QString payloadText;
+    for (int row = 0; row < source.rowCount(); ++row) {
+        if (row % CancelCheckRows == 0 && isInterruptionRequested())
+            return false;
+        ++readRows;
+
+        keyText.clear();
+        for (int col : key.keyColumns) {
+            QString text = source.cell(row, col);
+            if (key.normalizedColumns.contains(col)) {
+                if (options.collapseWhitespace)
+                    text = text.simplified();
+                if (options.foldCase)
+                    text = text.toCaseFolded();
+            }
+            keyText += text;
+            keyText += CellSeparator;
+        }
+        payloadText.clear();
+        for (int col : key.payloadColumns) {
+            payloadText += source.cell(row, col);
+            payloadText += CellSeparator;
+        }
+        const RowKey rowKey{qHash(keyText, 0), qHash(keyText, SecondKeySeed)};
+        const size_t payload = qHash(payloadText, 0);
+
+        const auto it = kept.constFind(rowKey);
+        if (it == kept.cend()) {
+            const int mergedRow = table.rowCount() + int(pending.size() / columns);
+            kept.insert(rowKey, {mergedRow, sourceIndex, payload});
+            for (int col = 0; col < columns; ++col)
+                pending << source.cell(row, col);
+            if (pending.size() >= qsizetype(AppendBatchRows) * columns)
+                flush();
+            ++mergedRows;
+        } else if (it->payload != payload) {
+            if (it->row >= table.rowCount())
+                flush();
+            addConflict(t, table, it->row, it->source, source, row, sourceIndex);
+        }
+    }
+    flush();
+    return true;
+}
+
+void CaseMerger::addConflict(CaseData::Table t, const CaseTable &table, int mergedRow, int keptSource,
+                             const CaseTable &source, int sourceRow, int sourceIndex)
+{
+    ++conflicts;
+    const TableKey key = tableKey(t);
+    QStringList keyCells;
+    for (int col : key.keyColumns)
+        keyCells << table.cell(mergedRow, col);
+    QStringList cells;
+    for (int col : key.payloadColumns) {
+        const QString keptValue = table.cell(mergedRow, col);
+        const QString otherValue = source.cell(sourceRow, col);
+        if (keptValue == otherValue || report.rowCount() + cells.size() / report.columnCount() >= MaxReportedConflicts)
+            continue;
+        cells << CaseData::tableKey(t) << keyCells.join(" | ") << table.columns().at(col).header
+              << keptValue << casePaths.at(keptSource) << otherValue << casePaths.at(sourceIndex);
+    }
+    report.appendRows(cells);
+}
+
+bool CaseMerger::fail(const QString &message)
+{
+    error = message;
+    mergeResult = Failed;
+    return false;
+}
@@ -0,0 +1,88 @@
+#ifndef CASEMERGER_H
+#define CASEMERGER_H
+
+#include "casedata.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QThread>
+
+// How entity names and types are compared when merging.
+struct MergeOptions
+{
+    bool foldCase = true;            // "ACME Corp" matches "acme corp"
+    bool collapseWhitespace = true;  // " ACME  Corp" matches "ACME Corp"
+};
+
+// Merges several case files into one on its own thread, dropping rows that
+// more than one case holds. Each table has key columns that decide whether
+// two rows are the same (entities: time, name and type; events: the whole
+// row; resources, media and hashes: the path), and rows are matched by a
+// 128-bit hash of their key, so the work is linear in the number of rows.
+// When rows share a key but disagree elsewhere, the first one is kept and
+// the disagreement goes to a conflict report, written as CSV next to the
+// merged case.
+//
+// The cases are read one at a time, the next one while the current one is
+// merged, so memory holds the merged case, its keys and at most two sources.
+// Cancel with requestInterruption(); result() is valid once finished() is emitted.
+class CaseMerger : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Result { Merged, Failed, Cancelled };
+
+    CaseMerger(const QStringList &casePaths, const QString &outputPath, const MergeOptions &options,
+               QObject *parent = nullptr);
+
+    Result result() const { return mergeResult; }
+    QString errorString() const { return error; }
+
+    QString mergedCasePath() const { return outputPath; }
+    qint64 rowsRead() const { return readRows; }
+    qint64 rowsMerged() const { return mergedRows; }
+    qint64 conflictCount() const { return conflicts; }
+    // The conflict report, or an empty string when there were no conflicts.
+    QString reportPath() const { return conflicts > 0 ? reportPathFor(outputPath) : QString(); }
+
+    static QString reportPathFor(const QString &outputPath);
+
+signals:
+    void progress(int casesMerged, int totalCases);
+
+protected:
+    void run() override;
+
+private:
+    struct RowKey {
+        size_t first;
+        size_t second;
+        bool operator==(const RowKey &other) const { return first == other.first && second == other.second; }
+    };
+    struct KeptRow {
+        int row;
+        int source;     // index into casePaths
+        size_t payload; // hash of the non-key columns
+    };
+    friend size_t qHash(const RowKey &key, size_t seed) { return key.first ^ seed; }
+
+    bool mergeTable(CaseData::Table t, const CaseTable &source, int sourceIndex);
+    void addConflict(CaseData::Table t, const CaseTable &table, int mergedRow, int keptSource,
+                     const CaseTable &source, int sourceRow, int sourceIndex);
+    bool fail(const QString &message);
+
+    const QStringList casePaths;
+    const QString outputPath;
+    const MergeOptions options;
+    CaseData merged;
+    QHash<RowKey, KeptRow> keys[CaseData::TableCount];
+    CaseTable report;
+    qint64 readRows = 0;
+    qint64 mergedRows = 0;
+    qint64 conflicts = 0;
+    Result mergeResult = Cancelled;
+    QString error;
+};
+
+#endif // CASEMERGER_H
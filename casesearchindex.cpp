@@ -0,0 +1,421 @@
+#include "casesearchindex.h"
+#include "perftrace.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Orders the postings of a word by line
+struct ByLine {
+    template <typename Posting>
+    bool operator()(const Posting &posting, int line) const { return posting.line < line; }
+    template <typename Posting>
+    bool operator()(int line, const Posting &posting) const { return line < posting.line; }
+};
+
+// Visits the postings of every indexed word that starts with `prefix`
+template <typename Postings, typename Visit>
+void forEachPrefixMatch(const QMap<QString, Postings> &index, const QString &prefix, Visit visit)
+{
+    for (auto it = index.lowerBound(prefix); it != index.cend() && it.key().startsWith(prefix); ++it)
+        visit(it.value());
+}
+
+} // namespace
+
+QList<CaseSearchIndex::Word> CaseSearchIndex::words(QStringView text)
+{
+    QList<Word> result;
+    qsizetype start = -1;
+    for (qsizetype i = 0; i <= text.size(); ++i) {
+        const bool inWord = i < text.size() && text[i].isLetterOrNumber();
+        if (inWord && start < 0) {
+            start = i;
+        } else if (!inWord && start >= 0) {
+            result.append({text.sliced(start, i - start).toString().toCaseFolded(), int(start)});
+            start = -1;
+        }
+    }
+    return result;
+}
+
+CaseSearchIndex::CaseSearchIndex(const std::function<const CaseTable &(int)> &tableContents,
+                                 const std::function<QString(int, int)> &notesText, QObject *parent)
+    : QObject(parent), tableContents(tableContents), notesText(notesText),
+      notesWatcher(new QFutureWatcher<NotesBuild>(this))
+{
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        tables[t].watcher = new QFutureWatcher<TableBuild>(this);
+        connect(tables[t].watcher, &QFutureWatcherBase::finished, this, [this, t]() { tableBuildFinished(t); });
+    }
+    connect(notesWatcher, &QFutureWatcherBase::finished, this, &CaseSearchIndex::notesBuildFinished);
+}
+
+// Indexes the strings added to the pool since the last call
+void CaseSearchIndex::indexStrings(TableIndex *index, const StringPool &strings)
+{
+    const quint32 count = quint32(strings.count());
+    // Read as UTF-8 so that strings of a mapped case are not decoded into the pool
+    QByteArray buffer;
+    for (quint32 id = index->indexedStrings; id < count; ++id) {
+        const QList<Word> found = words(QString::fromUtf8(strings.utf8(id, buffer)));
+        for (const Word &word : found) {
+            QList<quint32> &ids = index->postings[word.text];
+            // A string repeating a word is listed once
+            if (ids.isEmpty() || ids.last() != id)
+                ids.append(id);
+        }
+    }
+    index->indexedStrings = qMax(index->indexedStrings, count);
+}
+
+// Sorts the rows of each column by the string id in them, counting ids first
+QList<CaseSearchIndex::ColumnRows> CaseSearchIndex::indexRows(const CaseTable &contents)
+{
+    const int columns = contents.columnCount();
+    const int rows = contents.rowCount();
+    const qsizetype ids = contents.stringPool().count();
+    QList<ColumnRows> columnRows(columns);
+    for (int col = 0; col < columns; ++col) {
+        const bool text = contents.columns().at(col).type == CaseTable::Text;
+        const CaseTable::ColumnData &storage = contents.columnStorage(col);
+        // Free text kept in a time column is searched; parsed times are not
+        auto idAt = [&](int row) -> qint64 {
+            if (text)
+                return storage.text.at(row);
+            const qint64 value = storage.values.at(row);
+            return value < 0 ? -(value + 1) : 0;
+        };
+
+        ColumnRows &column = columnRows[col];
+        column.first.fill(0, ids + 1);
+        for (int row = 0; row < rows; ++row) {
+            const qint64 id = idAt(row);
+            if (id > 0 && id < ids)
+                ++column.first[id + 1];
+        }
+        for (qsizetype id = 1; id <= ids; ++id)
+            column.first[id] += column.first[id - 1];
+        column.rows.resize(column.first.at(ids));
+        QList<int> next = column.first;
+        for (int row = 0; row < rows; ++row) {
+            const qint64 id = idAt(row);
+            if (id > 0 && id < ids)
+                column.rows[next[id]++] = row;
+        }
+    }
+    return columnRows;
+}
+
+void CaseSearchIndex::resetTable(int table)
+{
+    TableState &state = tables[table];
+    state.index = TableIndex();
+    state.postingsReady = false;
+    state.rowsReady = false;
+    ++state.postingsGeneration;
+    ++state.rowsGeneration;
+    startTableBuild(table);
+}
+
+void CaseSearchIndex::tableEdited(int table)
+{
+    TableState &state = tables[table];
+    // New strings are few; the build in progress catches up with them otherwise
+    if (state.postingsReady)
+        indexStrings(&state.index, tableContents(table).stringPool());
+    state.rowsReady = false;
+    ++state.rowsGeneration;
+    startTableBuild(table);
+}
+
+void CaseSearchIndex::startTableBuild(int table)
+{
+    TableState &state = tables[table];
+    // A stale build is followed by a fresh one when it finishes
+    if (state.watcher->isRunning())
+        return;
+    const CaseTable contents = tableContents(table);
+    const bool withPostings = !state.postingsReady;
+    const quint64 postingsGeneration = state.postingsGeneration;
+    const quint64 rowsGeneration = state.rowsGeneration;
+    state.watcher->setFuture(QtConcurrent::run([contents, withPostings, postingsGeneration, rowsGeneration]() {
+        PERF_TRACE_SCOPE("search.indexTable");
+        TableBuild build;
+        build.withPostings = withPostings;
+        build.postingsGeneration = postingsGeneration;
+        build.rowsGeneration = rowsGeneration;
+        if (withPostings)
+            indexStrings(&build.index, contents.stringPool());
+        build.index.columnRows = indexRows(contents);
+        return build;
+    }));
+}
+
+void CaseSearchIndex::tableBuildFinished(int table)
+{
+    TableState &state = tables[table];
+    TableBuild build = state.watcher->result();
+    if (build.withPostings && build.postingsGeneration == state.postingsGeneration) {
+        state.index.postings = std::move(build.index.postings);
+        state.index.indexedStrings = build.index.indexedStrings;
+        state.postingsReady = true;
+        // Strings interned by edits since the copy was taken
+        indexStrings(&state.index, tableContents(table).stringPool());
+    }
+    if (state.postingsReady && build.rowsGeneration == state.rowsGeneration) {
+        state.index.columnRows = std::move(build.index.columnRows);
+        state.rowsReady = true;
+    }
+    if (!state.postingsReady || !state.rowsReady)
+        startTableBuild(table);
+    emit indexed();
+}
+
+void CaseSearchIndex::resetNotes()
+{
+    notes = NotesIndex();
+    notesReady = false;
+    ++notesGeneration;
+    startNotesBuild();
+}
+
+void CaseSearchIndex::startNotesBuild()
+{
+    if (notesWatcher->isRunning())
+        return;
+    const QString text = notesText(0, -1);
+    dirty = false;
+    pendingLength = int(text.size());
+    const quint64 generation = notesGeneration;
+    notesWatcher->setFuture(QtConcurrent::run([text, generation]() {
+        PERF_TRACE_SCOPE("search.indexNotes");
+        NotesBuild build;
+        build.generation = generation;
+        build.index.length = int(text.size());
+        replaceNotesLines(&build.index, 0, 0, 0, text);
+        return build;
+    }));
+}
+
+void CaseSearchIndex::notesBuildFinished()
+{
+    NotesBuild build = notesWatcher->result();
+    if (build.generation != notesGeneration) {
+        startNotesBuild();
+        return;
+    }
+    notes = std::move(build.index);
+    notesReady = true;
+    // Edits made while it was built come in as one edit of the range they touched
+    if (dirty) {
+        dirty = false;
+        editIndexedNotes(dirtyStart, notes.length - dirtyStart - dirtyTail, pendingLength - dirtyStart - dirtyTail);
+    }
+    emit indexed();
+}
+
+void CaseSearchIndex::editNotes(int position, int removed, int inserted)
+{
+    if (notesReady) {
+        editIndexedNotes(position, removed, inserted);
+        return;
+    }
+    // Being built from a copy: remember the span the edits could have changed
+    const int tail = pendingLength - (position + removed);
+    dirtyStart = dirty ? qMin(dirtyStart, position) : position;
+    dirtyTail = dirty ? qMin(dirtyTail, tail) : tail;
+    dirty = true;
+    pendingLength += inserted - removed;
+}
+
+void CaseSearchIndex::editIndexedNotes(int position, int removed, int inserted)
+{
+    if (position < 0 || removed < 0 || inserted < 0 || position + removed > notes.length) {
+        resetNotes();
+        return;
+    }
+
+    // The lines holding the start and the end of the replaced text
+    auto lineAt = [this](int pos) {
+        const auto it = std::upper_bound(notes.lines.cbegin(), notes.lines.cend(), pos,
+                                         [](int at, const NotesLine &line) { return at < line.start; });
+        return int(it - notes.lines.cbegin()) - 1;
+    };
+    const int first = lineAt(position);
+    const int last = lineAt(position + removed);
+    const int lastEnd = last + 1 < notes.lines.size() ? notes.lines.at(last + 1).start - 1 : notes.length;
+    const int delta = inserted - removed;
+    for (qsizetype line = last + 1; line < notes.lines.size(); ++line)
+        notes.lines[line].start += delta;
+    notes.length += delta;
+
+    const int start = notes.lines.at(first).start;
+    replaceNotesLines(&notes, first, last - first + 1, start, notesText(start, lastEnd + delta - start));
+}
+
+// Replaces `count` lines from `first` with the lines of `text`, which starts at `start` in the notes
+void CaseSearchIndex::replaceNotesLines(NotesIndex *index, int first, int count, int start, QStringView text)
+{
+    QMap<QString, QList<NotesPosting>> &postingsOfWord = index->postings;
+    for (int line = first; line < first + count; ++line) {
+        for (const QString &word : std::as_const(index->lines.at(line).words)) {
+            const auto it = postingsOfWord.find(word);
+            if (it == postingsOfWord.end())
+                continue;
+            QList<NotesPosting> &postings = it.value();
+            const auto range = std::equal_range(postings.begin(), postings.end(), line, ByLine());
+            postings.erase(range.first, range.second);
+            if (postings.isEmpty())
+                postingsOfWord.erase(it);
+        }
+    }
+
+    QList<NotesLine> lines;
+    QList<QList<Word>> lineWords;
+    for (qsizetype from = 0;;) {
+        qsizetype end = text.indexOf(u'\n', from);
+        if (end < 0)
+            end = text.size();
+        lines.append({start + int(from), {}});
+        lineWords.append(words(text.sliced(from, end - from)));
+        if (end == text.size())
+            break;
+        from = end + 1;
+    }
+
+    // Lines after the replaced ones move by as many lines as were added
+    const int moved = int(lines.size()) - count;
+    if (moved != 0) {
+        for (QList<NotesPosting> &postings : postingsOfWord) {
+            for (auto it = std::lower_bound(postings.begin(), postings.end(), first + count, ByLine()); it != postings.end(); ++it)
+                it->line += moved;
+        }
+    }
+
+    index->lines.remove(first, count);
+    index->lines.insert(first, lines.size(), NotesLine());
+    for (int i = 0; i < lines.size(); ++i) {
+        const int line = first + i;
+        NotesLine &target = index->lines[line];
+        target = lines.at(i);
+        for (const Word &word : lineWords.at(i)) {
+            QList<NotesPosting> &postings = postingsOfWord[word.text];
+            postings.insert(std::upper_bound(postings.begin(), postings.end(), line, ByLine()),
+                            NotesPosting{line, word.position, int(word.text.size())});
+            target.words.append(word.text);
+        }
+    }
+}
+
+bool CaseSearchIndex::isComplete() const
+{
+    if (!notesReady)
+        return false;
+    return std::all_of(std::begin(tables), std::end(tables), [](const TableState &state) { return state.postingsReady; });
+}
+
+int CaseSearchIndex::search(const QString &query, int maxHits, QList<Hit> *hits) const
+{
+    PERF_TRACE_SCOPE("search.query");
+    QStringList queryWords;
+    for (const Word &word : words(query)) {
+        if (!queryWords.contains(word.text))
+            queryWords.append(word.text);
+    }
+    if (queryWords.isEmpty() || queryWords.size() > 255)
+        return 0;
+    const int wordCount = int(queryWords.size());
+    int total = 0;
+    auto addHit = [&](const Hit &hit) {
+        if (total++ < maxHits)
+            hits->append(hit);
+    };
+
+    // Notes: a line that contains every query word is a hit, at the first word it matched
+    struct LineMatch {
+        int words = 0;
+        const NotesPosting *first = nullptr;
+    };
+    QMap<int, LineMatch> lines;
+    for (int w = 0; notesReady && w < wordCount; ++w) {
+        forEachPrefixMatch(notes.postings, queryWords.at(w), [&](const QList<NotesPosting> &postings) {
+            for (const NotesPosting &posting : postings) {
+                if (w == 0) {
+                    LineMatch &match = lines[posting.line];
+                    if (!match.first || posting.column < match.first->column)
+                        match.first = &posting;
+                    match.words = 1;
+                } else {
+                    const auto it = lines.find(posting.line);
+                    if (it != lines.end() && it->words == w)
+                        it->words = w + 1;
+                }
+            }
+        });
+    }
+    for (auto it = lines.cbegin(); it != lines.cend(); ++it) {
+        if (it->words == wordCount)
+            addHit({NotesTarget, it.key(), 0, notes.lines.at(it.key()).start + it->first->column, it->first->length});
+    }
+
+    // Tables: find the strings holding every query word, then the cells using them
+    for (int t = 0; t < CaseData::TableCount; ++t) {
+        const TableState &state = tables[t];
+        if (!state.postingsReady)
+            continue;
+        const TableIndex &index = state.index;
+        std::vector<quint8> matched(index.indexedStrings, 0);
+        QList<quint32> matchedIds;
+        for (int w = 0; w < wordCount; ++w) {
+            forEachPrefixMatch(index.postings, queryWords.at(w), [&](const QList<quint32> &ids) {
+                for (quint32 id : ids) {
+                    if (matched[id] == w) {
+                        matched[id] = quint8(w + 1);
+                        if (w + 1 == wordCount)
+                            matchedIds.append(id);
+                    }
+                }
+            });
+        }
+        if (matchedIds.isEmpty())
+            continue;
+
+        QList<std::pair<int, int>> cells;
+        if (state.rowsReady) {
+            for (int col = 0; col < index.columnRows.size(); ++col) {
+                const ColumnRows &column = index.columnRows.at(col);
+                for (quint32 id : std::as_const(matchedIds)) {
+                    if (id + 1 >= quint32(column.first.size()))
+                        continue;
+                    for (int i = column.first.at(id); i < column.first.at(id + 1); ++i)
+                        cells.append({column.rows.at(i), col});
+                }
+            }
+        } else {
+            // The row lists are being built again after an edit; look through the id columns meanwhile
+            const CaseTable &contents = tableContents(t);
+            const quint8 all = quint8(wordCount);
+            for (int col = 0; col < contents.columnCount(); ++col) {
+                const bool text = contents.columns().at(col).type == CaseTable::Text;
+                const CaseTable::ColumnData &storage = contents.columnStorage(col);
+                for (int row = 0; row < contents.rowCount(); ++row) {
+                    qint64 id = text ? qint64(storage.text.at(row)) : storage.values.at(row);
+                    if (!text)
+                        id = id < 0 ? -(id + 1) : 0;
+                    if (id > 0 && quint64(id) < matched.size() && matched[id] == all)
+                        cells.append({row, col});
+                }
+            }
+        }
+        // In table order, though only the cells that are listed need sorting
+        const qsizetype listed = qBound<qsizetype>(0, maxHits - total, cells.size());
+        std::partial_sort(cells.begin(), cells.begin() + listed, cells.end());
+        for (qsizetype i = 0; i < cells.size(); ++i)
+            addHit({t, cells.at(i).first, cells.at(i).second, 0, 0});
+    }
+    return total;
+}
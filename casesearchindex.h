@@ -0,0 +1,148 @@
+#ifndef CASESEARCHINDEX_H
+#define CASESEARCHINDEX_H
+
+#include "casedata.h"
+
+#include <QFutureWatcher>
+#include <QMap>
+#include <QObject>
+
+#include <functional>
+
+// Inverted index for searching the notes and the case tables as you type.
+// Text is split into words of letters and digits and case-folded; every query
+// word matches the indexed words it is a prefix of, and a hit must contain all
+// query words.
+//
+// Tables are indexed by string pool id rather than by cell: the index maps words
+// to the ids of the pool strings holding them, so it only grows as new strings
+// are interned and needs no updating when rows are inserted or removed.
+// A query resolves to a set of ids, and for each column a list of the rows
+// holding every id turns those into matching cells. Media and wall clock times
+// that parsed are numbers, not strings, and are not searched.
+//
+// The notes are indexed by line. An edit indexes again only the lines it
+// touched and moves the lines after it along.
+//
+// Whole tables and notes are indexed on the thread pool, from copies, when
+// they are loaded or replaced; edits made meanwhile are caught up when the
+// copy's index is taken in. Strings interned by an edit are indexed right
+// away, and the row lists of an edited table are built again in the
+// background; until they are, its matching strings are found by scanning the
+// id columns. search() itself never indexes.
+class CaseSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    // A matching cell, or for `table` NotesTarget a word in the notes.
+    struct Hit {
+        int table = 0;
+        int row = 0;
+        int column = 0;
+        int position = 0; // notes only
+        int length = 0;   // notes only
+    };
+    static constexpr int NotesTarget = -1;
+
+    // `tableContents` returns a table as it is now, `notesText` a range of the
+    // notes as they are now, or all of them for a length of -1.
+    CaseSearchIndex(const std::function<const CaseTable &(int)> &tableContents,
+                    const std::function<QString(int, int)> &notesText, QObject *parent = nullptr);
+
+    // The table was loaded or replaced by one with a different string pool.
+    void resetTable(int table);
+    // Cells of the table were edited, or rows inserted or removed.
+    void tableEdited(int table);
+    // The notes were loaded or replaced.
+    void resetNotes();
+    // The `removed` characters at `position` were replaced by `inserted` ones.
+    void editNotes(int position, int removed, int inserted);
+
+    // False while part of the case is still being indexed and not searched.
+    bool isComplete() const;
+    // Collects up to `maxHits` hits, notes first, and returns the total number.
+    int search(const QString &query, int maxHits, QList<Hit> *hits) const;
+
+signals:
+    // A background build was taken in; searches may now find more.
+    void indexed();
+
+private:
+    struct Word {
+        QString text;
+        int position;
+    };
+    static QList<Word> words(QStringView text);
+
+    struct NotesPosting {
+        int line;
+        int column; // in the line
+        int length;
+    };
+    struct NotesLine {
+        int start;
+        QStringList words; // the words its postings are listed under
+    };
+    struct NotesIndex {
+        QMap<QString, QList<NotesPosting>> postings;
+        QList<NotesLine> lines;
+        int length = 0;
+    };
+    struct NotesBuild {
+        NotesIndex index;
+        quint64 generation = 0;
+    };
+
+    // The rows holding string id `i` in a column are rows[first[i]] to rows[first[i + 1] - 1]
+    struct ColumnRows {
+        QList<int> first;
+        QList<int> rows;
+    };
+    struct TableIndex {
+        quint32 indexedStrings = 0;
+        QMap<QString, QList<quint32>> postings;
+        QList<ColumnRows> columnRows;
+    };
+    struct TableBuild {
+        TableIndex index;
+        bool withPostings = false;
+        quint64 postingsGeneration = 0;
+        quint64 rowsGeneration = 0;
+    };
+    struct TableState {
+        TableIndex index;
+        bool postingsReady = false;
+        bool rowsReady = false;
+        // Bumped by every change that makes a build started before it stale
+        quint64 postingsGeneration = 0;
+        quint64 rowsGeneration = 0;
+        QFutureWatcher<TableBuild> *watcher = nullptr;
+    };
+
+    static void indexStrings(TableIndex *index, const StringPool &strings);
+    static QList<ColumnRows> indexRows(const CaseTable &contents);
+    static void replaceNotesLines(NotesIndex *index, int first, int count, int start, QStringView text);
+    void startTableBuild(int table);
+    void tableBuildFinished(int table);
+    void startNotesBuild();
+    void notesBuildFinished();
+    void editIndexedNotes(int position, int removed, int inserted);
+
+    std::function<const CaseTable &(int)> tableContents;
+    std::function<QString(int, int)> notesText;
+    TableState tables[CaseData::TableCount];
+
+    NotesIndex notes;
+    bool notesReady = false;
+    quint64 notesGeneration = 0;
+    // Edits made while the notes are built: only the text between the first
+    // `dirtyStart` and the last `dirtyTail` characters changed
+    bool dirty = false;
+    int dirtyStart = 0;
+    int dirtyTail = 0;
+    int pendingLength = 0;
+    QFutureWatcher<NotesBuild> *notesWatcher;
+};
+
+#endif // CASESEARCHINDEX_H
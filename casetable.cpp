@@ -0,0 +1,459 @@
+#include "casetable.h"
+
+#include <QDate>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr qint64 MSecsPerDay = 86400000;
+constexpr qint64 UnixEpochJulianDay = 2440588;
+constexpr int DateTimeLength = 19;
+// Below this many rows a sort runs on the calling thread
+constexpr int ParallelSortRows = 65536;
+
+inline int digitAt(QStringView text, qsizetype i)
+{
+    const char16_t c = text[i].unicode();
+    return (c >= u'0' && c <= u'9') ? int(c - u'0') : -1;
+}
+
+inline int twoDigitsAt(QStringView text, qsizetype i)
+{
+    const int hi = digitAt(text, i);
+    const int lo = digitAt(text, i + 1);
+    return (hi < 0 || lo < 0) ? -1 : hi * 10 + lo;
+}
+
+template <typename Char>
+inline Char *writeTwoDigits(Char *out, int value)
+{
+    *out++ = Char('0' + value / 10);
+    *out++ = Char('0' + value % 10);
+    return out;
+}
+
+// Writes the media time so that it ends right before `end`; returns its start.
+template <typename Char>
+Char *writeMediaTime(Char *end, qint64 milliseconds)
+{
+    const qint64 totalSeconds = qMax<qint64>(milliseconds, 0) / 1000;
+    qint64 hours = totalSeconds / 3600;
+
+    Char *out = end;
+    const int minutes = int((totalSeconds % 3600) / 60);
+    const int seconds = int(totalSeconds % 60);
+    *--out = Char('0' + seconds % 10);
+    *--out = Char('0' + seconds / 10);
+    *--out = Char(':');
+    *--out = Char('0' + minutes % 10);
+    *--out = Char('0' + minutes / 10);
+    *--out = Char(':');
+    int hourDigits = 0;
+    do {
+        *--out = Char('0' + hours % 10);
+        hours /= 10;
+        ++hourDigits;
+    } while (hours > 0 || hourDigits < 2);
+    return out;
+}
+
+// Writes the DateTimeLength characters of a date and time.
+template <typename Char>
+void writeDateTime(Char *out, qint64 milliseconds)
+{
+    const qint64 value = qMax<qint64>(milliseconds, 0);
+    const QDate date = QDate::fromJulianDay(value / MSecsPerDay + UnixEpochJulianDay);
+    const int secondsOfDay = int((value % MSecsPerDay) / 1000);
+
+    out = writeTwoDigits(out, date.year() / 100);
+    out = writeTwoDigits(out, date.year() % 100);
+    *out++ = Char('-');
+    out = writeTwoDigits(out, date.month());
+    *out++ = Char('-');
+    out = writeTwoDigits(out, date.day());
+    *out++ = Char(' ');
+    out = writeTwoDigits(out, secondsOfDay / 3600);
+    *out++ = Char(':');
+    out = writeTwoDigits(out, (secondsOfDay % 3600) / 60);
+    *out++ = Char(':');
+    writeTwoDigits(out, secondsOfDay % 60);
+}
+
+// Moves values[rows] out of `values`, keeping the others in order.
+template <typename T>
+QList<T> takeValues(QList<T> &values, const QList<int> &rows)
+{
+    QList<T> taken;
+    taken.reserve(rows.size());
+    qsizetype kept = 0;
+    qsizetype next = 0;
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        if (next < rows.size() && rows.at(next) == i) {
+            taken.append(values.at(i));
+            ++next;
+        } else {
+            values[kept++] = values.at(i);
+        }
+    }
+    values.resize(kept);
+    return taken;
+}
+
+// Splits [0, count) into one slice per thread and runs `work(begin, end)` on each.
+template <typename Work>
+void forEachSlice(int count, Work work)
+{
+    const int slices = count < ParallelSortRows ? 1 : qMax(1, QThread::idealThreadCount());
+    QList<int> bounds;
+    for (int i = 0; i <= slices; ++i)
+        bounds.append(int(qint64(count) * i / slices));
+    QList<int> indexes(slices);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QtConcurrent::blockingMap(indexes, [&](int slice) { work(bounds.at(slice), bounds.at(slice + 1)); });
+}
+
+// Stable sort across the thread pool: every slice is sorted on its own, then
+// neighbouring slices are merged pairwise until one is left.
+template <typename Less>
+void parallelStableSort(QList<int> &rows, Less less)
+{
+    const int count = int(rows.size());
+    const int slices = count < ParallelSortRows ? 1 : qMax(1, QThread::idealThreadCount());
+    if (slices == 1) {
+        std::stable_sort(rows.begin(), rows.end(), less);
+        return;
+    }
+    int *data = rows.data();
+    QList<int> bounds;
+    for (int i = 0; i <= slices; ++i)
+        bounds.append(int(qint64(count) * i / slices));
+    QList<int> runs(slices);
+    std::iota(runs.begin(), runs.end(), 0);
+    QtConcurrent::blockingMap(runs, [&](int run) { std::stable_sort(data + bounds.at(run), data + bounds.at(run + 1), less); });
+    while (bounds.size() > 2) {
+        QList<int> pairs((bounds.size() - 1) / 2);
+        std::iota(pairs.begin(), pairs.end(), 0);
+        QtConcurrent::blockingMap(pairs, [&](int pair) {
+            std::inplace_merge(data + bounds.at(2 * pair), data + bounds.at(2 * pair + 1), data + bounds.at(2 * pair + 2), less);
+        });
+        QList<int> merged;
+        for (qsizetype i = 0; i < bounds.size(); i += 2)
+            merged.append(bounds.at(i));
+        if (merged.last() != count)
+            merged.append(count);
+        bounds = merged;
+    }
+}
+
+// Inverse of takeValues().
+template <typename T>
+void putValues(QList<T> &values, const QList<int> &rows, const QList<T> &taken)
+{
+    QList<T> merged;
+    merged.reserve(values.size() + taken.size());
+    qsizetype kept = 0;
+    qsizetype next = 0;
+    while (kept < values.size() || next < taken.size()) {
+        if (next < taken.size() && rows.at(next) == merged.size())
+            merged.append(taken.at(next++));
+        else
+            merged.append(values.at(kept++));
+    }
+    values = std::move(merged);
+}
+
+} // namespace
+
+CaseTable::CaseTable(const QList<Column> &columns)
+    : columnSpecs(columns), columnData(columns.size())
+{
+}
+
+CaseTable::CaseTable(const QList<Column> &columns, const StringPool &strings, const QList<ColumnData> &data, int rowCount)
+    : columnSpecs(columns), columnData(data), strings(strings), rows(rowCount)
+{
+}
+
+QStringList CaseTable::headers() const
+{
+    QStringList result;
+    for (const Column &column : columnSpecs)
+        result << column.header;
+    return result;
+}
+
+QString CaseTable::cell(int row, int column) const
+{
+    const ColumnData &data = columnData.at(column);
+    if (columnSpecs.at(column).type == Text)
+        return strings.at(data.text.at(row));
+
+    const qint64 value = data.values.at(row);
+    if (value < 0)
+        return strings.at(quint32(-(value + 1)));
+    return columnSpecs.at(column).type == MediaTime ? formatMediaTime(value) : formatDateTime(value);
+}
+
+QByteArrayView CaseTable::cellUtf8(int row, int column, QByteArray &buffer) const
+{
+    const ColumnData &data = columnData.at(column);
+    if (columnSpecs.at(column).type == Text)
+        return strings.utf8(data.text.at(row), buffer);
+
+    const qint64 value = data.values.at(row);
+    if (value < 0)
+        return strings.utf8(quint32(-(value + 1)), buffer);
+    if (buffer.size() < MediaTimeMaxLength)
+        buffer.resize(MediaTimeMaxLength);
+    if (columnSpecs.at(column).type == DateTime) {
+        writeDateTime(buffer.data(), value);
+        return QByteArrayView(buffer.constData(), DateTimeLength);
+    }
+    char *end = buffer.data() + MediaTimeMaxLength;
+    const char *start = writeMediaTime(end, value);
+    return QByteArrayView(start, end - start);
+}
+
+void CaseTable::setCell(int row, int column, const QString &text)
+{
+    const ColumnType type = columnSpecs.at(column).type;
+    if (type == Text)
+        columnData[column].text[row] = strings.intern(text);
+    else
+        columnData[column].values[row] = encodeTime(type, text);
+}
+
+qint64 CaseTable::timeValue(int row, int column) const
+{
+    if (columnSpecs.at(column).type == Text)
+        return -1;
+    return qMax<qint64>(columnData.at(column).values.at(row), -1);
+}
+
+void CaseTable::insertRows(int row, int count)
+{
+    for (int c = 0; c < columnSpecs.size(); ++c) {
+        if (columnSpecs.at(c).type == Text)
+            columnData[c].text.insert(row, count, 0);
+        else
+            columnData[c].values.insert(row, count, -1);
+    }
+    rows += count;
+}
+
+void CaseTable::removeRows(int row, int count)
+{
+    for (int c = 0; c < columnSpecs.size(); ++c) {
+        if (columnSpecs.at(c).type == Text)
+            columnData[c].text.remove(row, count);
+        else
+            columnData[c].values.remove(row, count);
+    }
+    rows -= count;
+}
+
+void CaseTable::appendRows(const QStringList &cells)
+{
+    const int columns = columnCount();
+    if (columns == 0)
+        return;
+    const int added = int(cells.size() / columns);
+
+    // Grow geometrically: loaders append many small batches in a row
+    for (int c = 0; c < columns; ++c) {
+        const ColumnType type = columnSpecs.at(c).type;
+        ColumnData &data = columnData[c];
+        if (type == Text) {
+            if (data.text.capacity() < rows + added)
+                data.text.reserve(qMax(rows + added, 2 * rows));
+            for (int r = 0; r < added; ++r)
+                data.text.append(strings.intern(cells.at(r * columns + c)));
+        } else {
+            if (data.values.capacity() < rows + added)
+                data.values.reserve(qMax(rows + added, 2 * rows));
+            for (int r = 0; r < added; ++r)
+                data.values.append(encodeTime(type, cells.at(r * columns + c)));
+        }
+    }
+    rows += added;
+}
+
+QList<CaseTable::ColumnData> CaseTable::takeRows(const QList<int> &rowList)
+{
+    QList<ColumnData> taken(columnSpecs.size());
+    for (int c = 0; c < columnSpecs.size(); ++c) {
+        if (columnSpecs.at(c).type == Text)
+            taken[c].text = takeValues(columnData[c].text, rowList);
+        else
+            taken[c].values = takeValues(columnData[c].values, rowList);
+    }
+    rows -= int(rowList.size());
+    return taken;
+}
+
+void CaseTable::putRows(const QList<int> &rowList, const QList<ColumnData> &cells)
+{
+    for (int c = 0; c < columnSpecs.size(); ++c) {
+        if (columnSpecs.at(c).type == Text)
+            putValues(columnData[c].text, rowList, cells.at(c).text);
+        else
+            putValues(columnData[c].values, rowList, cells.at(c).values);
+    }
+    rows += int(rowList.size());
+}
+
+void CaseTable::clear()
+{
+    columnData = QList<ColumnData>(columnSpecs.size());
+    strings.clear();
+    rows = 0;
+}
+
+QList<int> CaseTable::sortOrder(int column, Qt::SortOrder order) const
+{
+    QList<int> result(rows);
+    for (int r = 0; r < rows; ++r)
+        result[r] = r;
+    if (column < 0 || column >= columnCount())
+        return result;
+
+    // Rank every distinct string once, so the row sort itself only compares integers.
+    QList<quint32> rank(strings.count(), 0);
+    QList<quint32> used;
+    auto markUsed = [&](quint32 id) {
+        if (id != 0 && rank.at(id) == 0) {
+            rank[id] = 1;
+            used.append(id);
+        }
+    };
+    const ColumnData &data = columnData.at(column);
+    const bool isText = columnSpecs.at(column).type == Text;
+    for (int r = 0; r < rows; ++r) {
+        if (isText)
+            markUsed(data.text.at(r));
+        else if (data.values.at(r) < 0)
+            markUsed(quint32(-(data.values.at(r) + 1)));
+    }
+    std::sort(used.begin(), used.end(), [this](quint32 a, quint32 b) {
+        const int cmp = strings.at(a).compare(strings.at(b), Qt::CaseInsensitive);
+        return cmp != 0 ? cmp < 0 : strings.at(a) < strings.at(b);
+    });
+    for (int i = 0; i < used.size(); ++i)
+        rank[used.at(i)] = quint32(i + 1);
+
+    // Times sort numerically; free text in a time column sorts after every time.
+    QList<qint64> keys(rows);
+    qint64 *key = keys.data();
+    forEachSlice(rows, [&](int begin, int end) {
+        for (int r = begin; r < end; ++r) {
+            if (isText) {
+                key[r] = rank.at(data.text.at(r));
+            } else {
+                const qint64 value = data.values.at(r);
+                key[r] = value >= 0 ? value : std::numeric_limits<qint64>::max() / 2 + rank.at(quint32(-(value + 1)));
+            }
+        }
+    });
+
+    // Only the row numbers move; large tables are sorted on every core
+    const qint64 *sortKey = keys.constData();
+    if (order == Qt::AscendingOrder)
+        parallelStableSort(result, [sortKey](int a, int b) { return sortKey[a] < sortKey[b]; });
+    else
+        parallelStableSort(result, [sortKey](int a, int b) { return sortKey[a] > sortKey[b]; });
+    return result;
+}
+
+qint64 CaseTable::encodeTime(ColumnType type, const QString &text)
+{
+    const qint64 value = type == MediaTime ? parseMediaTime(text) : parseDateTime(text);
+    if (value >= 0)
+        return value;
+    return -qint64(strings.intern(text)) - 1;
+}
+
+// Accepts exactly what formatMediaTime() produces, so a parsed cell always
+// formats back to the text it came from.
+qint64 CaseTable::parseMediaTime(QStringView text)
+{
+    const qsizetype size = text.size();
+    if (size < 8 || size > 18 || text[size - 3] != u':' || text[size - 6] != u':')
+        return -1;
+    const qsizetype hourDigits = size - 6;
+    if (hourDigits > 2 && text[0] == u'0')
+        return -1;
+
+    qint64 hours = 0;
+    for (qsizetype i = 0; i < hourDigits; ++i) {
+        const int digit = digitAt(text, i);
+        if (digit < 0)
+            return -1;
+        hours = hours * 10 + digit;
+    }
+    const int minutes = twoDigitsAt(text, size - 5);
+    const int seconds = twoDigitsAt(text, size - 2);
+    if (minutes < 0 || minutes > 59 || seconds < 0 || seconds > 59)
+        return -1;
+    return ((hours * 60 + minutes) * 60 + seconds) * 1000;
+}
+
+QString CaseTable::formatMediaTime(qint64 milliseconds)
+{
+    char16_t buffer[MediaTimeMaxLength];
+    char16_t *end = buffer + MediaTimeMaxLength;
+    const char16_t *start = writeMediaTime(end, milliseconds);
+    return QString(reinterpret_cast<const QChar *>(start), end - start);
+}
+
+int CaseTable::formatMediaTime(qint64 milliseconds, char16_t *out)
+{
+    char16_t buffer[MediaTimeMaxLength];
+    char16_t *end = buffer + MediaTimeMaxLength;
+    const char16_t *start = writeMediaTime(end, milliseconds);
+    std::copy(start, static_cast<const char16_t *>(end), out);
+    return int(end - start);
+}
+
+// "yyyy-MM-dd hh:mm:ss", read as a naive timestamp so the value does not depend
+// on the time zone the case was opened in.
+qint64 CaseTable::parseDateTime(QStringView text)
+{
+    if (text.size() != 19 || text[4] != u'-' || text[7] != u'-' || text[10] != u' '
+        || text[13] != u':' || text[16] != u':')
+        return -1;
+
+    const int century = twoDigitsAt(text, 0);
+    const int yearOfCentury = twoDigitsAt(text, 2);
+    const int month = twoDigitsAt(text, 5);
+    const int day = twoDigitsAt(text, 8);
+    const int hour = twoDigitsAt(text, 11);
+    const int minute = twoDigitsAt(text, 14);
+    const int second = twoDigitsAt(text, 17);
+    if (century < 0 || yearOfCentury < 0 || hour < 0 || hour > 23 || minute < 0 || minute > 59
+        || second < 0 || second > 59)
+        return -1;
+
+    const QDate date(century * 100 + yearOfCentury, month, day);
+    if (!date.isValid())
+        return -1;
+    const qint64 days = date.toJulianDay() - UnixEpochJulianDay;
+    const qint64 value = days * MSecsPerDay + ((hour * 60 + minute) * 60 + second) * 1000;
+    return value >= 0 ? value : -1;
+}
+
+QString CaseTable::formatDateTime(qint64 milliseconds)
+{
+    char16_t buffer[DateTimeLength];
+    writeDateTime(buffer, milliseconds);
+    return QString(reinterpret_cast<const QChar *>(buffer), DateTimeLength);
+}
+
+int CaseTable::formatDateTime(qint64 milliseconds, char16_t *out)
+{
+    writeDateTime(out, milliseconds);
+    return DateTimeLength;
+}
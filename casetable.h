@@ -0,0 +1,98 @@
+#ifndef CASETABLE_H
+#define CASETABLE_H
+
+#include "stringpool.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Column-oriented storage for one of the case tables (entities, events, resources).
+// Text cells are ids into a shared StringPool; time cells are stored as integer
+// milliseconds so they can be compared and sorted without parsing. A time cell
+// whose text does not parse keeps that text verbatim, so nothing is ever lost.
+// CaseTable is a value type made of implicitly shared containers: copies are
+// cheap and only detach the columns that are actually modified afterwards.
+class CaseTable
+{
+public:
+    enum ColumnType {
+        Text,       // free text
+        MediaTime,  // media position, "hh:mm:ss"
+        DateTime    // wall clock, "yyyy-MM-dd hh:mm:ss"
+    };
+
+    struct Column {
+        QString header;
+        ColumnType type = Text;
+    };
+
+    // Encoded cell storage of one column. Text columns use `text`, ids into the
+    // table's StringPool. Time columns use `values`: a value >= 0 is a time in
+    // milliseconds, a negative value v is free text with string id -(v + 1).
+    struct ColumnData {
+        QList<quint32> text;
+        QList<qint64> values;
+    };
+
+    CaseTable() = default;
+    explicit CaseTable(const QList<Column> &columns);
+    // Adopts already encoded storage, e.g. read from a binary case file.
+    CaseTable(const QList<Column> &columns, const StringPool &strings, const QList<ColumnData> &data, int rowCount);
+
+    const QList<Column> &columns() const { return columnSpecs; }
+    QStringList headers() const;
+    int columnCount() const { return int(columnSpecs.size()); }
+    int rowCount() const { return rows; }
+
+    QString cell(int row, int column) const;
+    // The cell as UTF-8, viewing either the string pool or `buffer`, which the
+    // caller reuses between cells. Unlike cell() this never modifies the table,
+    // so copies of one table can be read like this from several threads.
+    QByteArrayView cellUtf8(int row, int column, QByteArray &buffer) const;
+    void setCell(int row, int column, const QString &text);
+    // Milliseconds held by a time cell, or -1 if the cell is empty or free text.
+    qint64 timeValue(int row, int column) const;
+
+    // Encoded storage, for serializers that write ids and raw times instead of text.
+    const StringPool &stringPool() const { return strings; }
+    const ColumnData &columnStorage(int column) const { return columnData.at(column); }
+
+    void insertRows(int row, int count);
+    void removeRows(int row, int count);
+    // Appends rows from a flat, row-major list holding columnCount() cells per row.
+    void appendRows(const QStringList &cells);
+    // Removes any set of rows, given in ascending order, in one pass and
+    // returns their encoded cells. The cells keep their string ids, which stay
+    // valid for as long as the pool is not cleared, so putRows() can bring the
+    // rows back without interning their text again.
+    QList<ColumnData> takeRows(const QList<int> &rows);
+    // Undoes takeRows(): after the call the rows are back at the given indexes.
+    void putRows(const QList<int> &rows, const QList<ColumnData> &cells);
+    void clear();
+
+    // Row order that sorts the table by a column: row i of the sorted table is row order[i].
+    // Text is compared case-insensitively, time columns numerically.
+    QList<int> sortOrder(int column, Qt::SortOrder order) const;
+
+    static qint64 parseMediaTime(QStringView text);
+    static QString formatMediaTime(qint64 milliseconds);
+    // Writes the media time to `out`, which holds MediaTimeMaxLength characters,
+    // and returns its length. Does not allocate.
+    static int formatMediaTime(qint64 milliseconds, char16_t *out);
+    static constexpr int MediaTimeMaxLength = 24;
+    static qint64 parseDateTime(QStringView text);
+    static QString formatDateTime(qint64 milliseconds);
+    // Same into `out`, which holds MediaTimeMaxLength characters; returns the length.
+    static int formatDateTime(qint64 milliseconds, char16_t *out);
+
+private:
+    qint64 encodeTime(ColumnType type, const QString &text);
+
+    QList<Column> columnSpecs;
+    QList<ColumnData> columnData;
+    StringPool strings;
+    int rows = 0;
+};
+
+#endif // CASETABLE_H
@@ -0,0 +1,176 @@
+#include "casetablefilter.h"
+
+#include <QStringDecoder>
+#include <QStringMatcher>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Below this many rows or strings a term is matched on the calling thread
+constexpr int ParallelFilterItems = 32768;
+
+// Splits [0, count) into one slice per thread and runs `work(begin, end)` on each.
+template <typename Work>
+void forEachSlice(int count, Work work)
+{
+    const int slices = count < ParallelFilterItems ? 1 : qMax(1, QThread::idealThreadCount());
+    QList<int> bounds;
+    for (int i = 0; i <= slices; ++i)
+        bounds.append(int(qint64(count) * i / slices));
+    QList<int> indexes(slices);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QtConcurrent::blockingMap(indexes, [&](int slice) { work(bounds.at(slice), bounds.at(slice + 1)); });
+}
+
+bool isAscii(QByteArrayView text)
+{
+    return std::all_of(text.begin(), text.end(), [](char c) { return uchar(c) < 0x80; });
+}
+
+char asciiLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c + ('a' - 'A')) : c;
+}
+
+// Case-insensitive search for a lowercase ASCII needle in ASCII text
+bool containsAscii(QByteArrayView text, QByteArrayView needle)
+{
+    const qsizetype last = text.size() - needle.size();
+    for (qsizetype i = 0; i <= last; ++i) {
+        qsizetype j = 0;
+        while (j < needle.size() && asciiLower(text[i + j]) == needle[j])
+            ++j;
+        if (j == needle.size())
+            return true;
+    }
+    return false;
+}
+
+// Splits the filter text at whitespace outside quotes; quotes are dropped.
+QStringList splitTerms(const QString &text)
+{
+    QStringList parts;
+    QString current;
+    bool quoted = false;
+    for (const QChar c : text) {
+        if (c == u'"') {
+            quoted = !quoted;
+        } else if (c.isSpace() && !quoted) {
+            if (!current.isEmpty())
+                parts << current;
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!current.isEmpty())
+        parts << current;
+    return parts;
+}
+
+} // namespace
+
+CaseTableFilter::CaseTableFilter(const QString &text, const QList<CaseTable::Column> &columns)
+{
+    QList<int> allColumns(columns.size());
+    std::iota(allColumns.begin(), allColumns.end(), 0);
+    const QStringList parts = splitTerms(text);
+    for (QString part : parts) {
+        Term term;
+        if (part.size() > 1 && part.startsWith(u'-')) {
+            term.exclude = true;
+            part.remove(0, 1);
+        }
+        const qsizetype colon = part.indexOf(u':');
+        if (colon > 0) {
+            const QString name = part.left(colon);
+            for (int c = 0; c < columns.size(); ++c) {
+                if (columns.at(c).header.contains(name, Qt::CaseInsensitive))
+                    term.columns.append(c);
+            }
+        }
+        if (term.columns.isEmpty()) {
+            term.text = part;
+            term.columns = allColumns;
+        } else {
+            term.text = part.mid(colon + 1);
+        }
+        // "type:" alone is still being typed
+        if (!term.text.isEmpty())
+            terms.append(term);
+    }
+}
+
+QList<bool> CaseTableFilter::matchRows(const CaseTable &table) const
+{
+    const int rows = table.rowCount();
+    QList<bool> matches(rows, true);
+    if (terms.isEmpty() || rows == 0)
+        return matches;
+
+    const StringPool &strings = table.stringPool();
+    const int stringCount = strings.count();
+    QList<bool> stringMatches(stringCount);
+    bool *rowFlags = matches.data();
+    for (const Term &term : terms) {
+        const QStringMatcher matcher(term.text, Qt::CaseInsensitive);
+        QByteArray asciiText = term.text.toUtf8();
+        const bool asciiTerm = isAscii(asciiText);
+        std::transform(asciiText.begin(), asciiText.end(), asciiText.begin(), asciiLower);
+
+        // Which strings hold the term. Strings the pool holds decoded are
+        // matched in place; the rest are read as UTF-8 from a copy of the pool,
+        // which never decodes into it, so the copies can be read in parallel.
+        // ASCII text is searched as bytes and only other text is decoded, into
+        // a buffer that is reused.
+        bool *stringFlags = stringMatches.data();
+        forEachSlice(stringCount, [&](int begin, int end) {
+            const StringPool pool = strings;
+            QByteArray unused;
+            QString decodedText;
+            for (int id = begin; id < end; ++id) {
+                if (id == 0) {
+                    stringFlags[id] = false;
+                } else if (const QString *text = pool.decoded(quint32(id))) {
+                    stringFlags[id] = matcher.indexIn(*text) >= 0;
+                } else if (const QByteArrayView bytes = pool.utf8(quint32(id), unused); asciiTerm && isAscii(bytes)) {
+                    stringFlags[id] = containsAscii(bytes, asciiText);
+                } else {
+                    QStringDecoder decoder(QStringDecoder::Utf8);
+                    decodedText.resize(decoder.requiredSpace(bytes.size()));
+                    const QChar *decodedEnd = decoder.appendToBuffer(decodedText.data(), bytes);
+                    stringFlags[id] = matcher.indexIn(QStringView(decodedText.constData(), decodedEnd - decodedText.constData())) >= 0;
+                }
+            }
+        });
+
+        forEachSlice(rows, [&](int begin, int end) {
+            char16_t text[CaseTable::MediaTimeMaxLength];
+            for (int r = begin; r < end; ++r) {
+                if (!rowFlags[r])
+                    continue;
+                bool found = false;
+                for (int column : term.columns) {
+                    const CaseTable::ColumnData &data = table.columnStorage(column);
+                    const CaseTable::ColumnType type = table.columns().at(column).type;
+                    if (type == CaseTable::Text) {
+                        found = stringFlags[data.text.at(r)];
+                    } else if (const qint64 value = data.values.at(r); value < 0) {
+                        found = stringFlags[-(value + 1)];
+                    } else {
+                        const int length = type == CaseTable::MediaTime ? CaseTable::formatMediaTime(value, text)
+                                                                        : CaseTable::formatDateTime(value, text);
+                        found = matcher.indexIn(QStringView(text, length)) >= 0;
+                    }
+                    if (found)
+                        break;
+                }
+                rowFlags[r] = found != term.exclude;
+            }
+        });
+    }
+    return matches;
+}
@@ -0,0 +1,36 @@
+#ifndef CASETABLEFILTER_H
+#define CASETABLEFILTER_H
+
+#include "casetable.h"
+
+// Filter bar expression for one table: whitespace-separated terms that a row
+// must all match, case-insensitively. "acme" matches a row with "acme" in any
+// column, "type:person" only looks at the columns whose header contains
+// "type", "-acme" keeps the rows that do not match, and quotes keep a phrase
+// with spaces in one term. A prefix that names no column is part of the text,
+// so "00:01:30" matches times.
+//
+// Rows are evaluated across the thread pool. Text is matched once per distinct
+// string in the table's pool, not once per cell, and a row then only looks up
+// its string ids; times are formatted into a stack buffer and matched there.
+class CaseTableFilter
+{
+public:
+    CaseTableFilter() = default;
+    CaseTableFilter(const QString &text, const QList<CaseTable::Column> &columns);
+
+    bool isEmpty() const { return terms.isEmpty(); }
+    // One flag per row of `table`.
+    QList<bool> matchRows(const CaseTable &table) const;
+
+private:
+    struct Term {
+        QString text;
+        QList<int> columns;
+        bool exclude = false;
+    };
+
+    QList<Term> terms;
+};
+
+#endif // CASETABLEFILTER_H
@@ -0,0 +1,321 @@
+#include "casetablemodel.h"
+#include "perftrace.h"
+
+#include <QColor>
+#include <QUndoStack>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+enum CommandId { CellCommandId = 1 };
+
+bool isContiguous(const QList<int> &rows)
+{
+    return !rows.isEmpty() && rows.last() - rows.first() + 1 == rows.size();
+}
+
+QList<int> rowRange(int first, int count)
+{
+    QList<int> rows(count);
+    std::iota(rows.begin(), rows.end(), first);
+    return rows;
+}
+
+} // namespace
+
+// Typing into the same cell again merges into one command
+class CaseTableModel::CellCommand : public QUndoCommand
+{
+public:
+    CellCommand(CaseTableModel *model, int row, int column, const QString &oldText, const QString &newText)
+        : QUndoCommand(QStringLiteral("Edit Cell")), model(model), row(row), column(column), oldText(oldText), newText(newText)
+    {
+    }
+
+    int id() const override { return CellCommandId; }
+    bool mergeWith(const QUndoCommand *other) override
+    {
+        const CellCommand *edit = static_cast<const CellCommand *>(other);
+        if (edit->model != model || edit->row != row || edit->column != column)
+            return false;
+        newText = edit->newText;
+        return true;
+    }
+    void redo() override { model->applyCell(row, column, newText); }
+    void undo() override { model->applyCell(row, column, oldText); }
+
+private:
+    CaseTableModel *model;
+    int row;
+    int column;
+    QString oldText;
+    QString newText;
+};
+
+// Inserted or removed rows. While the rows are out of the table their encoded
+// cells are kept here, so bringing them back interns no text.
+class CaseTableModel::RowsCommand : public QUndoCommand
+{
+public:
+    // Removal
+    RowsCommand(CaseTableModel *model, const QList<int> &rows)
+        : QUndoCommand(QString("Remove %1 Row(s)").arg(rows.size())), model(model), rows(rows), insertion(false)
+    {
+    }
+    // Insertion of `count` rows at `row`, filled from `texts`
+    RowsCommand(CaseTableModel *model, int row, int count, const QStringList &texts, const QString &text)
+        : QUndoCommand(text), model(model), rows(rowRange(row, count)), texts(texts), insertion(true)
+    {
+    }
+
+    void redo() override
+    {
+        if (!insertion) {
+            cells = model->applyTake(rows);
+        } else if (cells.isEmpty()) {
+            model->applyInsert(rows.first(), texts, int(rows.size()));
+            texts.clear();
+        } else {
+            model->applyPut(rows, cells);
+            cells.clear();
+        }
+    }
+    void undo() override
+    {
+        if (insertion) {
+            cells = model->applyTake(rows);
+        } else {
+            model->applyPut(rows, cells);
+            cells.clear();
+        }
+    }
+
+private:
+    CaseTableModel *model;
+    QList<int> rows; // ascending
+    QList<CaseTable::ColumnData> cells;
+    QStringList texts;
+    bool insertion;
+};
+
+// Both tables share their storage with the ones they were copied from
+class CaseTableModel::ReplaceCommand : public QUndoCommand
+{
+public:
+    ReplaceCommand(CaseTableModel *model, const CaseTable &oldTable, const CaseTable &newTable, const QString &text)
+        : QUndoCommand(text), model(model), oldTable(oldTable), newTable(newTable)
+    {
+    }
+
+    void redo() override { model->setTable(newTable); }
+    void undo() override { model->setTable(oldTable); }
+
+private:
+    CaseTableModel *model;
+    CaseTable oldTable;
+    CaseTable newTable;
+};
+
+CaseTableModel::CaseTableModel(const QList<CaseTable::Column> &columns, QObject *parent)
+    : QAbstractTableModel(parent), caseTable(columns)
+{
+}
+
+void CaseTableModel::setTable(const CaseTable &table)
+{
+    PERF_TRACE_SCOPE("table.set");
+    beginResetModel();
+    highlightedRows.clear();
+    caseTable = table;
+    endResetModel();
+}
+
+void CaseTableModel::appendRows(const QStringList &cells)
+{
+    PERF_TRACE_SCOPE("table.append");
+    const int added = caseTable.columnCount() > 0 ? int(cells.size() / caseTable.columnCount()) : 0;
+    if (added == 0)
+        return;
+    const int first = caseTable.rowCount();
+    beginInsertRows(QModelIndex(), first, first + added - 1);
+    caseTable.appendRows(cells);
+    endInsertRows();
+}
+
+void CaseTableModel::clear()
+{
+    beginResetModel();
+    highlightedRows.clear();
+    caseTable.clear();
+    endResetModel();
+}
+
+int CaseTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : caseTable.rowCount();
+}
+
+int CaseTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : caseTable.columnCount();
+}
+
+void CaseTableModel::setHighlightedRows(const QList<int> &rows)
+{
+    const QSet<int> highlighted(rows.cbegin(), rows.cend());
+    const QSet<int> previous = highlightedRows;
+    highlightedRows = highlighted;
+    const int lastColumn = caseTable.columnCount() - 1;
+    for (int row : previous) {
+        if (!highlighted.contains(row) && row < caseTable.rowCount())
+            emit dataChanged(index(row, 0), index(row, lastColumn), {Qt::BackgroundRole});
+    }
+    for (int row : highlighted) {
+        if (!previous.contains(row) && row < caseTable.rowCount())
+            emit dataChanged(index(row, 0), index(row, lastColumn), {Qt::BackgroundRole});
+    }
+}
+
+QVariant CaseTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    if (role == Qt::BackgroundRole)
+        return highlightedRows.contains(index.row()) ? QVariant(QColor(0, 122, 204, 90)) : QVariant();
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+        return QVariant();
+    return caseTable.cell(index.row(), index.column());
+}
+
+bool CaseTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::EditRole)
+        return false;
+    const QString text = value.toString();
+    const QString oldText = caseTable.cell(index.row(), index.column());
+    if (oldText == text)
+        return true;
+    perform(new CellCommand(this, index.row(), index.column(), oldText, text));
+    return true;
+}
+
+QVariant CaseTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+    if (orientation == Qt::Vertical)
+        return section + 1;
+    return caseTable.columns().value(section).header;
+}
+
+Qt::ItemFlags CaseTableModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable;
+}
+
+bool CaseTableModel::insertRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || row > caseTable.rowCount() || count <= 0)
+        return false;
+    perform(new RowsCommand(this, row, count, QStringList(), QStringLiteral("Add Row(s)")));
+    return true;
+}
+
+bool CaseTableModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > caseTable.rowCount())
+        return false;
+    perform(new RowsCommand(this, rowRange(row, count)));
+    return true;
+}
+
+void CaseTableModel::insertCells(int row, const QStringList &cells, const QString &text)
+{
+    const int count = caseTable.columnCount() > 0 ? int(cells.size() / caseTable.columnCount()) : 0;
+    if (row < 0 || row > caseTable.rowCount() || count == 0)
+        return;
+    perform(new RowsCommand(this, row, count, cells, text));
+}
+
+void CaseTableModel::removeRowSet(QList<int> rows)
+{
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    if (rows.isEmpty() || rows.first() < 0 || rows.last() >= caseTable.rowCount())
+        return;
+    perform(new RowsCommand(this, rows));
+}
+
+void CaseTableModel::replaceTable(const CaseTable &table, const QString &text)
+{
+    perform(new ReplaceCommand(this, caseTable, table, text));
+}
+
+void CaseTableModel::perform(QUndoCommand *command)
+{
+    if (undoStack) {
+        undoStack->push(command);
+    } else {
+        command->redo();
+        delete command;
+    }
+}
+
+void CaseTableModel::applyCell(int row, int column, const QString &text)
+{
+    PERF_TRACE_SCOPE("table.setCell");
+    caseTable.setCell(row, column, text);
+    const QModelIndex changed = index(row, column);
+    emit dataChanged(changed, changed, {Qt::DisplayRole, Qt::EditRole});
+}
+
+void CaseTableModel::applyInsert(int row, const QStringList &cells, int count)
+{
+    PERF_TRACE_SCOPE("table.insertRows");
+    beginInsertRows(QModelIndex(), row, row + count - 1);
+    highlightedRows.clear();
+    caseTable.insertRows(row, count);
+    const int columns = caseTable.columnCount();
+    for (int i = 0; i < cells.size() && i < count * columns; ++i) {
+        if (!cells.at(i).isEmpty())
+            caseTable.setCell(row + i / columns, i % columns, cells.at(i));
+    }
+    endInsertRows();
+}
+
+QList<CaseTable::ColumnData> CaseTableModel::applyTake(const QList<int> &rows)
+{
+    PERF_TRACE_SCOPE("table.removeRows");
+    const bool contiguous = isContiguous(rows);
+    if (contiguous)
+        beginRemoveRows(QModelIndex(), rows.first(), rows.last());
+    else
+        beginResetModel();
+    highlightedRows.clear();
+    const QList<CaseTable::ColumnData> cells = caseTable.takeRows(rows);
+    if (contiguous)
+        endRemoveRows();
+    else
+        endResetModel();
+    return cells;
+}
+
+void CaseTableModel::applyPut(const QList<int> &rows, const QList<CaseTable::ColumnData> &cells)
+{
+    PERF_TRACE_SCOPE("table.restoreRows");
+    const bool contiguous = isContiguous(rows);
+    if (contiguous)
+        beginInsertRows(QModelIndex(), rows.first(), rows.last());
+    else
+        beginResetModel();
+    highlightedRows.clear();
+    caseTable.putRows(rows, cells);
+    if (contiguous)
+        endInsertRows();
+    else
+        endResetModel();
+}
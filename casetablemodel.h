@@ -0,0 +1,70 @@
+#ifndef CASETABLEMODEL_H
+#define CASETABLEMODEL_H
+
+#include "casetable.h"
+
+#include <QAbstractTableModel>
+#include <QSet>
+
+class QUndoCommand;
+class QUndoStack;
+
+// Item model exposing a CaseTable to a QTableView. Unlike QTableWidget it does
+// not allocate an item per cell, so large tables stay cheap to hold and repaint.
+//
+// With an undo stack set, every edit made through the model (cells, inserted
+// and removed rows, replaced tables) is pushed onto it as a command holding
+// just the delta: a cell's old and new text, or the encoded cells of the
+// removed rows. Sorting is left to the view's CaseTableProxyModel and never
+// moves the model's rows. setTable(), appendRows() and clear()
+// are for loading a case and are never recorded; clear the stack after them.
+class CaseTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit CaseTableModel(const QList<CaseTable::Column> &columns, QObject *parent = nullptr);
+
+    const CaseTable &table() const { return caseTable; }
+    void setTable(const CaseTable &table);
+    void appendRows(const QStringList &cells);
+    void clear();
+    void setUndoStack(QUndoStack *stack) { undoStack = stack; }
+
+    // Undoable edits, under the given name in the undo history.
+    // Inserts rows filled from a flat, row-major list of cells.
+    void insertCells(int row, const QStringList &cells, const QString &text);
+    // Removes any set of rows in one pass; the view is reset once unless the rows are contiguous.
+    void removeRowSet(QList<int> rows);
+    void replaceTable(const CaseTable &table, const QString &text);
+
+    // Rows drawn with a highlight background, e.g. events active at the playback
+    // position. Any change to the rows themselves drops the highlight.
+    void setHighlightedRows(const QList<int> &rows);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+
+private:
+    class CellCommand;
+    class RowsCommand;
+    class ReplaceCommand;
+
+    void perform(QUndoCommand *command);
+    void applyCell(int row, int column, const QString &text);
+    void applyInsert(int row, const QStringList &cells, int count);
+    QList<CaseTable::ColumnData> applyTake(const QList<int> &rows);
+    void applyPut(const QList<int> &rows, const QList<CaseTable::ColumnData> &cells);
+
+    QUndoStack *undoStack = nullptr;
+    CaseTable caseTable;
+    QSet<int> highlightedRows;
+};
+
+#endif // CASETABLEMODEL_H
@@ -0,0 +1,231 @@
+#include "casetableproxymodel.h"
+#include "casetablemodel.h"
+#include "perftrace.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+CaseTableProxyModel::CaseTableProxyModel(QObject *parent)
+    : QAbstractProxyModel(parent)
+{
+}
+
+void CaseTableProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    beginResetModel();
+    if (caseModel)
+        disconnect(caseModel, nullptr, this, nullptr);
+    QAbstractProxyModel::setSourceModel(model);
+    caseModel = qobject_cast<CaseTableModel *>(model);
+    if (caseModel) {
+        filter = CaseTableFilter(filterString, caseModel->table().columns());
+        connect(caseModel, &QAbstractItemModel::dataChanged, this, &CaseTableProxyModel::sourceDataChanged);
+        connect(caseModel, &QAbstractItemModel::rowsInserted, this, &CaseTableProxyModel::sourceRowsInserted);
+        connect(caseModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &CaseTableProxyModel::sourceRowsAboutToBeRemoved);
+        connect(caseModel, &QAbstractItemModel::rowsRemoved, this, &CaseTableProxyModel::sourceRowsRemoved);
+        connect(caseModel, &QAbstractItemModel::modelAboutToBeReset, this, &CaseTableProxyModel::sourceAboutToBeReset);
+        connect(caseModel, &QAbstractItemModel::modelReset, this, &CaseTableProxyModel::sourceReset);
+    }
+    setOrder(filteredOrder());
+    endResetModel();
+}
+
+void CaseTableProxyModel::setFilterText(const QString &text)
+{
+    if (text == filterString)
+        return;
+    filterString = text;
+    if (caseModel)
+        filter = CaseTableFilter(text, caseModel->table().columns());
+    invalidate();
+}
+
+void CaseTableProxyModel::invalidate()
+{
+    beginResetModel();
+    setOrder(filteredOrder());
+    endResetModel();
+}
+
+QModelIndex CaseTableProxyModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!caseModel || !proxyIndex.isValid() || proxyIndex.row() >= sourceRows.size())
+        return QModelIndex();
+    return caseModel->index(sourceRows.at(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex CaseTableProxyModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid() || sourceIndex.row() >= proxyRows.size())
+        return QModelIndex();
+    const int row = proxyRows.at(sourceIndex.row());
+    return row < 0 ? QModelIndex() : createIndex(row, sourceIndex.column());
+}
+
+QModelIndex CaseTableProxyModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= sourceRows.size() || column < 0 || column >= columnCount())
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex CaseTableProxyModel::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int CaseTableProxyModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(sourceRows.size());
+}
+
+int CaseTableProxyModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() || !caseModel ? 0 : caseModel->columnCount();
+}
+
+void CaseTableProxyModel::sort(int column, Qt::SortOrder order)
+{
+    sortColumn = column;
+    sortOrder = order;
+    if (!caseModel)
+        return;
+    const QList<int> rows = filteredOrder();
+    // Rows added since the last filter may drop out
+    if (rows.size() != sourceRows.size()) {
+        beginResetModel();
+        setOrder(rows);
+        endResetModel();
+        return;
+    }
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QList<int> oldSourceRows;
+    oldSourceRows.reserve(oldIndexes.size());
+    for (const QModelIndex &oldIndex : oldIndexes)
+        oldSourceRows.append(sourceRows.at(oldIndex.row()));
+    setOrder(rows);
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (int i = 0; i < oldIndexes.size(); ++i)
+        newIndexes.append(index(proxyRows.at(oldSourceRows.at(i)), oldIndexes.at(i).column()));
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+// The model rows to show, in the order to show them
+QList<int> CaseTableProxyModel::filteredOrder() const
+{
+    PERF_TRACE_SCOPE("view.sortAndFilter");
+    if (!caseModel)
+        return {};
+    const CaseTable &table = caseModel->table();
+    QList<int> order;
+    if (sortColumn >= 0 && sortColumn < table.columnCount()) {
+        order = table.sortOrder(sortColumn, sortOrder);
+    } else {
+        order.resize(table.rowCount());
+        std::iota(order.begin(), order.end(), 0);
+    }
+    if (filter.isEmpty())
+        return order;
+    const QList<bool> matches = filter.matchRows(table);
+    order.removeIf([&matches](int row) { return !matches.at(row); });
+    return order;
+}
+
+void CaseTableProxyModel::setOrder(const QList<int> &order)
+{
+    PERF_TRACE_SCOPE("view.mapRows");
+    sourceRows = order;
+    proxyRows = QList<int>(caseModel ? caseModel->rowCount() : 0, -1);
+    for (int i = 0; i < sourceRows.size(); ++i)
+        proxyRows[sourceRows.at(i)] = i;
+}
+
+void CaseTableProxyModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles)
+{
+    int first = std::numeric_limits<int>::max();
+    int last = -1;
+    for (int row = topLeft.row(); row <= bottomRight.row() && row < proxyRows.size(); ++row) {
+        const int proxyRow = proxyRows.at(row);
+        if (proxyRow >= 0) {
+            first = qMin(first, proxyRow);
+            last = qMax(last, proxyRow);
+        }
+    }
+    if (last >= 0)
+        emit dataChanged(index(first, topLeft.column()), index(last, bottomRight.column()), roles);
+}
+
+void CaseTableProxyModel::sourceRowsInserted(const QModelIndex &, int first, int last)
+{
+    const int count = last - first + 1;
+    // Appending, as a load does, leaves the other rows where they are
+    if (first < proxyRows.size()) {
+        for (int &row : sourceRows) {
+            if (row >= first)
+                row += count;
+        }
+    }
+    const int proxyFirst = int(sourceRows.size());
+    beginInsertRows(QModelIndex(), proxyFirst, proxyFirst + count - 1);
+    proxyRows.insert(first, count, -1);
+    for (int i = 0; i < count; ++i) {
+        proxyRows[first + i] = proxyFirst + i;
+        sourceRows.append(first + i);
+    }
+    endInsertRows();
+}
+
+void CaseTableProxyModel::sourceRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+{
+    QList<int> removed;
+    for (int row = first; row <= last; ++row) {
+        if (proxyRows.at(row) >= 0)
+            removed.append(proxyRows.at(row));
+    }
+    std::sort(removed.begin(), removed.end());
+    if (removed.isEmpty()) {
+        pendingRemoval = NoRemoval;
+    } else if (removed.last() - removed.first() + 1 == removed.size()) {
+        pendingRemoval = RangeRemoval;
+        beginRemoveRows(QModelIndex(), removed.first(), removed.last());
+    } else {
+        // Rows scattered by a sort go in one reset rather than one removal each
+        pendingRemoval = ResetRemoval;
+        beginResetModel();
+    }
+}
+
+void CaseTableProxyModel::sourceRowsRemoved(const QModelIndex &, int first, int last)
+{
+    const int count = last - first + 1;
+    QList<int> kept;
+    kept.reserve(sourceRows.size());
+    for (int row : std::as_const(sourceRows)) {
+        if (row < first)
+            kept.append(row);
+        else if (row > last)
+            kept.append(row - count);
+    }
+    setOrder(kept);
+    if (pendingRemoval == RangeRemoval)
+        endRemoveRows();
+    else if (pendingRemoval == ResetRemoval)
+        endResetModel();
+    pendingRemoval = NoRemoval;
+}
+
+void CaseTableProxyModel::sourceAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void CaseTableProxyModel::sourceReset()
+{
+    setOrder(filteredOrder());
+    endResetModel();
+}
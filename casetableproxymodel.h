@@ -0,0 +1,65 @@
+#ifndef CASETABLEPROXYMODEL_H
+#define CASETABLEPROXYMODEL_H
+
+#include "casetablefilter.h"
+
+#include <QAbstractProxyModel>
+
+class CaseTableModel;
+
+// Sorted and filtered view of a CaseTableModel. The view's rows are a
+// permutation index over the model's rows: sorting and filtering rebuild the
+// index and never move the rows themselves, so neither is an edit of the case.
+// Sorting compares typed keys (times as milliseconds, text by rank) and both
+// run across the thread pool; see CaseTable::sortOrder() and CaseTableFilter.
+//
+// The index is rebuilt on sort(), on a new filter and when the whole table
+// changes. Rows added in between are shown at the end, matching or not, so a
+// row just added to a filtered table can still be filled in, and an edited
+// row keeps its place until the next sort.
+class CaseTableProxyModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit CaseTableProxyModel(QObject *parent = nullptr);
+
+    // The source must be a CaseTableModel.
+    void setSourceModel(QAbstractItemModel *model) override;
+
+    QString filterText() const { return filterString; }
+    void setFilterText(const QString &text);
+    // Sorts and filters all rows again, e.g. after rows were streamed in.
+    void invalidate();
+
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+    enum Removal { NoRemoval, RangeRemoval, ResetRemoval };
+
+    QList<int> filteredOrder() const;
+    void setOrder(const QList<int> &order);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles);
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void sourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void sourceAboutToBeReset();
+    void sourceReset();
+
+    CaseTableModel *caseModel = nullptr;
+    QList<int> sourceRows; // view row -> model row
+    QList<int> proxyRows;  // model row -> view row, -1 if filtered out
+    int sortColumn = -1;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    QString filterString;
+    CaseTableFilter filter;
+    Removal pendingRemoval = NoRemoval;
+};
+
+#endif // CASETABLEPROXYMODEL_H
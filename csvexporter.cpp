@@ -0,0 +1,189 @@
+#include "csvexporter.h"
+#include "perftrace.h"
+
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include <cstring>
+
+#ifdef DATAORGANIZER_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr int ChunkRows = 8192;
+
+void appendField(QByteArray &out, QByteArrayView text, const CsvDialect &dialect)
+{
+    bool quoted = dialect.quoting == CsvDialect::QuoteAll;
+    for (qsizetype i = 0; !quoted && i < text.size(); ++i) {
+        const char c = text[i];
+        quoted = c == dialect.delimiter || c == '"' || c == '\n' || c == '\r';
+    }
+    if (!quoted) {
+        out.append(text);
+        return;
+    }
+
+    out.append('"');
+    const char *data = text.data();
+    const char *end = data + text.size();
+    while (const char *quote = static_cast<const char *>(std::memchr(data, '"', end - data))) {
+        out.append(data, quote - data + 1);
+        out.append('"');
+        data = quote + 1;
+    }
+    out.append(data, end - data);
+    out.append('"');
+}
+
+#ifdef DATAORGANIZER_ZLIB
+QByteArray gzipMember(const QByteArray &data)
+{
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return QByteArray();
+    QByteArray out(qsizetype(deflateBound(&stream, uLong(data.size()))), Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = uInt(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = uInt(out.size());
+    const int status = deflate(&stream, Z_FINISH);
+    out.resize(qsizetype(stream.total_out));
+    deflateEnd(&stream);
+    return status == Z_STREAM_END ? out : QByteArray();
+}
+#endif
+
+// The bytes written for one run of rows; an empty result means compression failed.
+QByteArray formatRows(const CaseTable &table, int first, int last, const CsvDialect &dialect)
+{
+    PERF_TRACE_SCOPE("csv.formatChunk");
+    QByteArray out;
+    out.reserve(qsizetype(last - first) * table.columnCount() * 16);
+    QByteArray buffer;
+    for (int row = first; row < last; ++row) {
+        for (int col = 0; col < table.columnCount(); ++col) {
+            if (col > 0)
+                out.append(dialect.delimiter);
+            appendField(out, table.cellUtf8(row, col, buffer), dialect);
+        }
+        out.append(dialect.newline);
+    }
+#ifdef DATAORGANIZER_ZLIB
+    if (dialect.gzip)
+        return gzipMember(out);
+#endif
+    return out;
+}
+
+QByteArray formatHeader(const CaseTable &table, const CsvDialect &dialect)
+{
+    QByteArray out;
+    const QStringList headers = table.headers();
+    for (int col = 0; col < headers.size(); ++col) {
+        if (col > 0)
+            out.append(dialect.delimiter);
+        appendField(out, headers.at(col).toUtf8(), dialect);
+    }
+    out.append(dialect.newline);
+#ifdef DATAORGANIZER_ZLIB
+    if (dialect.gzip)
+        return gzipMember(out);
+#endif
+    return out;
+}
+
+} // namespace
+
+CsvExporter::CsvExporter(const QList<Target> &targets, const CsvDialect &dialect, QObject *parent)
+    : QThread(parent), targets(targets), dialect(dialect)
+{
+    for (const Target &target : targets)
+        totalRows += target.table.rowCount();
+}
+
+bool CsvExporter::isGzipSupported()
+{
+#ifdef DATAORGANIZER_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CsvExporter::run()
+{
+    if (dialect.gzip && !isGzipSupported()) {
+        fail(QStringLiteral("This build cannot write gzip files."));
+        return;
+    }
+    for (const Target &target : targets) {
+        if (!exportTable(target))
+            return;
+    }
+    exportResult = Exported;
+}
+
+bool CsvExporter::exportTable(const Target &target)
+{
+    PERF_TRACE_SCOPE("csv.exportTable");
+    QSaveFile file(target.filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return fail(QStringLiteral("Could not write to file: ") + file.errorString());
+    const QByteArray header = formatHeader(target.table, dialect);
+    if (header.isEmpty() || file.write(header) != header.size())
+        return fail(QStringLiteral("Could not write to file: ") + file.errorString());
+
+    QList<int> chunkStarts;
+    for (int row = 0; row < target.table.rowCount(); row += ChunkRows)
+        chunkStarts.append(row);
+
+    // Chunks are formatted a window at a time, so at most two windows of output
+    // (the one being written and the one being formatted) are held in memory.
+    const CaseTable &table = target.table;
+    const int window = qMax(2, QThread::idealThreadCount() * 2);
+    auto formatWindow = [&](qsizetype first) {
+        return QtConcurrent::mapped(chunkStarts.mid(first, window), [&table, this](int start) {
+            return formatRows(table, start, qMin(start + ChunkRows, table.rowCount()), dialect);
+        });
+    };
+
+    QFuture<QByteArray> current = formatWindow(0);
+    for (qsizetype first = 0; first < chunkStarts.size(); first += window) {
+        QFuture<QByteArray> next;
+        if (first + window < chunkStarts.size())
+            next = formatWindow(first + window);
+
+        const int chunks = int(qMin<qsizetype>(window, chunkStarts.size() - first));
+        for (int i = 0; i < chunks; ++i) {
+            const QByteArray bytes = current.resultAt(i);
+            if (isInterruptionRequested() || bytes.isEmpty() || file.write(bytes) != bytes.size()) {
+                current.cancel();
+                next.cancel();
+                current.waitForFinished();
+                next.waitForFinished();
+                file.cancelWriting();
+                if (isInterruptionRequested())
+                    return false;
+                return fail(bytes.isEmpty() ? QStringLiteral("Could not compress the export.")
+                                            : QStringLiteral("Could not write to file: ") + file.errorString());
+            }
+            rowsWritten += qMin(ChunkRows, table.rowCount() - chunkStarts.at(first + i));
+            emit progress(rowsWritten, totalRows);
+        }
+        current = next;
+    }
+
+    if (!file.commit())
+        return fail(QStringLiteral("Could not write to file: ") + file.errorString());
+    return true;
+}
+
+bool CsvExporter::fail(const QString &message)
+{
+    exportResult = Failed;
+    error = message;
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef CSVEXPORTER_H
+#define CSVEXPORTER_H
+
+#include "casetable.h"
+
+#include <QByteArray>
+#include <QThread>
+
+// How exported CSV files are written.
+struct CsvDialect
+{
+    enum Quoting {
+        QuoteAll,     // every field in double quotes
+        QuoteMinimal  // only fields holding the delimiter, quotes or line breaks
+    };
+
+    char delimiter = ',';
+    Quoting quoting = QuoteAll;
+    bool gzip = false;
+#if defined(Q_OS_WIN)
+    QByteArray newline = "\r\n";
+#else
+    QByteArray newline = "\n";
+#endif
+};
+
+// Writes case tables to CSV files on its own thread. Rows are formatted, and
+// compressed when writing gzip, in chunks spread over the global thread pool;
+// the chunks are then written in order, a bounded number of them ahead of the
+// file. Each gzip chunk is a complete gzip member, which any gzip reader
+// decompresses as one stream. The tables are copies, so the case can be edited
+// while an export runs.
+// Cancel with requestInterruption(); result() is valid once finished() is emitted.
+class CsvExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Result { Exported, Failed, Cancelled };
+
+    struct Target {
+        QString filePath;
+        CaseTable table;
+    };
+
+    CsvExporter(const QList<Target> &targets, const CsvDialect &dialect, QObject *parent = nullptr);
+
+    Result result() const { return exportResult; }
+    QString errorString() const { return error; }
+
+    static bool isGzipSupported();
+
+signals:
+    void progress(qint64 rowsWritten, qint64 totalRows);
+
+protected:
+    void run() override;
+
+private:
+    bool exportTable(const Target &target);
+    bool fail(const QString &message);
+
+    const QList<Target> targets;
+    const CsvDialect dialect;
+    qint64 totalRows = 0;
+    qint64 rowsWritten = 0;
+    Result exportResult = Cancelled;
+    QString error;
+};
+
+#endif // CSVEXPORTER_H
@@ -0,0 +1,272 @@
+#include "csvimporter.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+#include <cstring>
+
+namespace {
+
+constexpr qsizetype ChunkBytes = 4 * 1024 * 1024;
+constexpr qsizetype SniffBytes = 64 * 1024;
+
+// Splits records into fields. Quoted fields may hold delimiters, line breaks
+// and doubled quotes; a quote anywhere else is kept as text. Lines without a
+// quote, by far the common case, are split with memchr alone.
+class RecordParser
+{
+public:
+    // With an empty column map every field is collected, in order.
+    RecordParser(const QList<int> &columnMap, char delimiter)
+        : columnMap(columnMap), delimiter(delimiter)
+    {
+    }
+
+    // Parses the record at `pos` into `row` and returns the position after it.
+    // Blank lines leave `row` empty.
+    qsizetype parse(const char *data, qsizetype pos, qsizetype size, QStringList &row)
+    {
+        if (columnMap.isEmpty())
+            row.clear();
+        else
+            row.fill(QString(), columnMap.size());
+
+        const char *lineEnd = static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+        const qsizetype end = lineEnd ? lineEnd - data : size;
+        const qsizetype next = lineEnd ? end + 1 : size;
+        const qsizetype content = (end > pos && data[end - 1] == '\r') ? end - 1 : end;
+        if (content == pos) {
+            row.clear();
+            return next;
+        }
+        if (!std::memchr(data + pos, '"', content - pos)) {
+            int field = 0;
+            while (const char *sep = static_cast<const char *>(std::memchr(data + pos, delimiter, content - pos))) {
+                store(row, field++, QByteArrayView(data + pos, sep - (data + pos)));
+                pos = sep - data + 1;
+            }
+            store(row, field, QByteArrayView(data + pos, content - pos));
+            return next;
+        }
+        return parseQuoted(data, pos, size, row);
+    }
+
+private:
+    qsizetype parseQuoted(const char *data, qsizetype pos, qsizetype size, QStringList &row)
+    {
+        for (int field = 0;; ++field) {
+            scratch.clear();
+            if (pos < size && data[pos] == '"') {
+                ++pos;
+                for (;;) {
+                    const char *quote = static_cast<const char *>(std::memchr(data + pos, '"', size - pos));
+                    if (!quote) {
+                        scratch.append(data + pos, size - pos);
+                        pos = size;
+                        break;
+                    }
+                    scratch.append(data + pos, quote - (data + pos));
+                    pos = quote - data + 1;
+                    if (pos < size && data[pos] == '"') {
+                        scratch.append('"');
+                        ++pos;
+                        continue;
+                    }
+                    break;
+                }
+            }
+            // Unquoted text, or anything trailing a closing quote, runs to the next separator
+            qsizetype fieldEnd = pos;
+            while (fieldEnd < size && data[fieldEnd] != delimiter && data[fieldEnd] != '\n')
+                ++fieldEnd;
+            qsizetype textEnd = fieldEnd;
+            if ((fieldEnd == size || data[fieldEnd] == '\n') && textEnd > pos && data[textEnd - 1] == '\r')
+                --textEnd;
+            scratch.append(data + pos, textEnd - pos);
+            store(row, field, scratch);
+
+            if (fieldEnd >= size)
+                return size;
+            if (data[fieldEnd] == '\n')
+                return fieldEnd + 1;
+            pos = fieldEnd + 1;
+        }
+    }
+
+    void store(QStringList &row, int field, QByteArrayView text)
+    {
+        if (columnMap.isEmpty()) {
+            row.append(QString::fromUtf8(text));
+            return;
+        }
+        for (int c = 0; c < columnMap.size(); ++c) {
+            if (columnMap.at(c) == field)
+                row[c] = QString::fromUtf8(text);
+        }
+    }
+
+    const QList<int> &columnMap;
+    const char delimiter;
+    QByteArray scratch;
+};
+
+struct Chunk
+{
+    qsizetype start = 0; // where parsing began
+    qsizetype end = 0;   // after the last record that starts before the chunk limit
+    QStringList cells;   // row-major, one entry per table column
+};
+
+// Parses the records starting in [start, limit).
+Chunk parseChunk(const char *data, qsizetype size, qsizetype start, qsizetype limit,
+                 const QList<int> &columnMap, char delimiter)
+{
+    Chunk chunk;
+    chunk.start = start;
+    RecordParser parser(columnMap, delimiter);
+    QStringList row;
+    qsizetype pos = start;
+    while (pos < limit && pos < size) {
+        pos = parser.parse(data, pos, size, row);
+        chunk.cells.append(row);
+    }
+    chunk.end = pos;
+    return chunk;
+}
+
+qsizetype skipByteOrderMark(const char *data, qsizetype size)
+{
+    return (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+}
+
+} // namespace
+
+CsvImporter::CsvImporter(const QString &filePath, const CaseTable &table, const QList<int> &columnMap,
+                         char delimiter, bool hasHeader, QObject *parent)
+    : QThread(parent), filePath(filePath), columnMap(columnMap), delimiter(delimiter),
+      hasHeader(hasHeader), target(table)
+{
+}
+
+char CsvImporter::detectDelimiter(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == QLatin1String("tsv") || suffix == QLatin1String("tab"))
+        return '\t';
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return ',';
+    const QByteArray line = file.readLine(SniffBytes);
+    char best = ',';
+    qsizetype bestCount = line.count(',');
+    for (char candidate : {';', '\t'}) {
+        const qsizetype count = line.count(candidate);
+        if (count > bestCount) {
+            best = candidate;
+            bestCount = count;
+        }
+    }
+    return best;
+}
+
+QStringList CsvImporter::readFirstRecord(const QString &filePath, char delimiter)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QStringList();
+    const QByteArray head = file.read(SniffBytes);
+    const QList<int> allFields;
+    RecordParser parser(allFields, delimiter);
+    QStringList fields;
+    parser.parse(head.constData(), skipByteOrderMark(head.constData(), head.size()), head.size(), fields);
+    return fields;
+}
+
+void CsvImporter::run()
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail(QStringLiteral("Couldn't open import file: ") + file.errorString());
+        return;
+    }
+    const qsizetype size = qsizetype(file.size());
+    const char *data = nullptr;
+    if (size > 0) {
+        data = reinterpret_cast<const char *>(file.map(0, size));
+        if (!data) {
+            fail(QStringLiteral("Couldn't map import file: ") + file.errorString());
+            return;
+        }
+    }
+
+    qsizetype dataStart = skipByteOrderMark(data, size);
+    if (hasHeader && dataStart < size) {
+        RecordParser parser(columnMap, delimiter);
+        QStringList header;
+        dataStart = parser.parse(data, dataStart, size, header);
+    }
+
+    // Nominal chunk limits; a chunk's records are those starting before its limit
+    QList<qsizetype> limits;
+    for (qsizetype limit = dataStart + ChunkBytes; limit < size; limit += ChunkBytes)
+        limits.append(limit);
+    limits.append(size);
+
+    // Guess where each chunk's first record starts: just after a line break
+    auto speculativeStart = [data, size, dataStart, &limits](int chunk) -> qsizetype {
+        if (chunk == 0)
+            return dataStart;
+        const qsizetype from = limits.at(chunk - 1);
+        const char *lineEnd = static_cast<const char *>(std::memchr(data + from - 1, '\n', size - from + 1));
+        return lineEnd ? lineEnd - data + 1 : size;
+    };
+    auto parseWindow = [&](int first, int count) {
+        QList<int> chunks;
+        for (int i = first; i < first + count; ++i)
+            chunks.append(i);
+        return QtConcurrent::mapped(std::move(chunks), [&, this](int chunk) {
+            return parseChunk(data, size, speculativeStart(chunk), limits.at(chunk), columnMap, delimiter);
+        });
+    };
+
+    // Parse a window of chunks ahead while the previous one is appended
+    const int chunkCount = int(limits.size());
+    const int window = qMax(2, QThread::idealThreadCount() * 2);
+    QFuture<Chunk> current = parseWindow(0, qMin(window, chunkCount));
+    qsizetype expectedStart = dataStart;
+    for (int first = 0; first < chunkCount; first += window) {
+        QFuture<Chunk> next;
+        if (first + window < chunkCount)
+            next = parseWindow(first + window, qMin(window, chunkCount - first - window));
+
+        const int chunks = qMin(window, chunkCount - first);
+        for (int i = 0; i < chunks; ++i) {
+            if (isInterruptionRequested()) {
+                current.cancel();
+                next.cancel();
+                current.waitForFinished();
+                next.waitForFinished();
+                return;
+            }
+            Chunk chunk = current.resultAt(i);
+            if (chunk.start != expectedStart) {
+                // The guess landed inside a quoted field that spans chunks
+                chunk = parseChunk(data, size, expectedStart, limits.at(first + i), columnMap, delimiter);
+            }
+            expectedStart = chunk.end;
+            target.appendRows(chunk.cells);
+            rowsImported += int(chunk.cells.size() / qMax<qsizetype>(1, columnMap.size()));
+            emit progress(chunk.end, size);
+        }
+        current = next;
+    }
+    importResult = Imported;
+}
+
+bool CsvImporter::fail(const QString &message)
+{
+    importResult = Failed;
+    error = message;
+    return false;
+}
@@ -0,0 +1,62 @@
+#ifndef CSVIMPORTER_H
+#define CSVIMPORTER_H
+
+#include "casetable.h"
+
+#include <QList>
+#include <QStringList>
+#include <QThread>
+
+// Reads a CSV or TSV file into a case table on its own thread. The file is
+// mapped into memory and cut into chunks that are tokenized in parallel on the
+// global thread pool. Each chunk is parsed speculatively from the first line
+// start in it; a chunk whose guess was wrong (its first line was really inside
+// a quoted field of the previous chunk) is parsed again from where the previous
+// chunk ended, so the result is exactly that of a single sequential pass.
+// Parsed rows are appended in file order to a copy of the target table, which
+// the GUI takes over once the import has finished.
+// Cancel with requestInterruption(); result() is valid once finished() is emitted.
+class CsvImporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Result { Imported, Failed, Cancelled };
+
+    // `columnMap` gives, for each column of `table`, the CSV field that fills it
+    // or -1 to leave it blank.
+    CsvImporter(const QString &filePath, const CaseTable &table, const QList<int> &columnMap,
+                char delimiter, bool hasHeader, QObject *parent = nullptr);
+
+    Result result() const { return importResult; }
+    QString errorString() const { return error; }
+    // The target table with the imported rows appended.
+    const CaseTable &table() const { return target; }
+    int importedRows() const { return rowsImported; }
+
+    // Tab for .tsv and .tab files, otherwise whichever of comma, semicolon and
+    // tab occurs most in the first line.
+    static char detectDelimiter(const QString &filePath);
+    // The fields of the first record, e.g. the column names.
+    static QStringList readFirstRecord(const QString &filePath, char delimiter);
+
+signals:
+    void progress(qint64 bytesRead, qint64 totalBytes);
+
+protected:
+    void run() override;
+
+private:
+    bool fail(const QString &message);
+
+    const QString filePath;
+    const QList<int> columnMap;
+    const char delimiter;
+    const bool hasHeader;
+    CaseTable target;
+    int rowsImported = 0;
+    Result importResult = Cancelled;
+    QString error;
+};
+
+#endif // CSVIMPORTER_H
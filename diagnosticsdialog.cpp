@@ -0,0 +1,115 @@
+#include "diagnosticsdialog.h"
+#include "perftrace.h"
+
+#include <QCheckBox>
+#include <QDateTime>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSettings>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+
+constexpr int RefreshInterval = 500;
+
+QTableWidgetItem *numberItem(const QString &text)
+{
+    QTableWidgetItem *item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+QString milliseconds(double nanoseconds)
+{
+    return QString::number(nanoseconds / 1e6, 'f', 3);
+}
+
+} // namespace
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Diagnostics");
+    resize(640, 420);
+
+    recordCheck = new QCheckBox("Record trace points");
+    recordCheck->setChecked(PerfTrace::isEnabled());
+    countersTable = new QTableWidget(0, 5);
+    countersTable->setHorizontalHeaderLabels({"Trace Point", "Calls", "Total (ms)", "Mean (ms)", "Max (ms)"});
+    countersTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    countersTable->verticalHeader()->hide();
+    countersTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    countersTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    threadsLabel = new QLabel;
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    QPushButton *clearButton = buttons->addButton("C&lear", QDialogButtonBox::ResetRole);
+    QPushButton *dumpButton = buttons->addButton("Dump &Trace...", QDialogButtonBox::ActionRole);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(recordCheck);
+    layout->addWidget(countersTable);
+    layout->addWidget(threadsLabel);
+    layout->addWidget(buttons);
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(RefreshInterval);
+
+    connect(recordCheck, &QCheckBox::toggled, this, [](bool checked){
+        PerfTrace::setEnabled(checked);
+        QSettings().setValue("diagnostics/trace", checked);
+    });
+    connect(clearButton, &QPushButton::clicked, this, [this](){ PerfTrace::clear(); refresh(); });
+    connect(dumpButton, &QPushButton::clicked, this, [this](){ dumpTrace(this); });
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(refreshTimer, &QTimer::timeout, this, &DiagnosticsDialog::refresh);
+}
+
+void DiagnosticsDialog::dumpTrace(QWidget *parent)
+{
+    const QString defaultFileName = QDir::homePath() + "/dataorganizer-trace-"
+                                  + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json";
+    const QString filePath = QFileDialog::getSaveFileName(parent, "Dump Trace", defaultFileName, "Trace Files (*.json);;All Files (*)");
+    if (filePath.isEmpty())
+        return;
+    QString errorString;
+    if (!PerfTrace::writeChromeTrace(filePath, &errorString))
+        QMessageBox::critical(parent, "Error", "Failed to write the trace: " + errorString);
+}
+
+void DiagnosticsDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    recordCheck->setChecked(PerfTrace::isEnabled());
+    refresh();
+    refreshTimer->start();
+}
+
+void DiagnosticsDialog::hideEvent(QHideEvent *event)
+{
+    refreshTimer->stop();
+    QDialog::hideEvent(event);
+}
+
+void DiagnosticsDialog::refresh()
+{
+    const QList<PerfTrace::Summary> summaries = PerfTrace::summaries();
+    countersTable->setRowCount(int(summaries.size()));
+    for (int row = 0; row < summaries.size(); ++row) {
+        const PerfTrace::Summary &summary = summaries.at(row);
+        countersTable->setItem(row, 0, new QTableWidgetItem(summary.name));
+        countersTable->setItem(row, 1, numberItem(QString::number(summary.count)));
+        countersTable->setItem(row, 2, numberItem(milliseconds(double(summary.totalNanoseconds))));
+        countersTable->setItem(row, 3, numberItem(milliseconds(double(summary.totalNanoseconds) / qMax<qint64>(1, summary.count))));
+        countersTable->setItem(row, 4, numberItem(milliseconds(double(summary.maxNanoseconds))));
+    }
+    threadsLabel->setText(QString("%1 thread(s) traced; counts cover the latest %2 trace points of each thread.")
+                              .arg(PerfTrace::threadCount()).arg(PerfTrace::TraceRingEvents));
+}
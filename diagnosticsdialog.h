@@ -0,0 +1,38 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QCheckBox;
+class QLabel;
+class QTableWidget;
+class QTimer;
+
+// Help > Diagnostics: turns the PerfTrace points on and off and shows, per
+// trace point, how often it ran and how long it took, refreshed twice a second
+// while the dialog is open. The trace can be written out for chrome://tracing
+// or ui.perfetto.dev to attach to a bug report.
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+
+    // Asks for a file and writes the recorded trace to it.
+    static void dumpTrace(QWidget *parent);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void refresh();
+
+    QCheckBox *recordCheck;
+    QTableWidget *countersTable;
+    QLabel *threadsLabel;
+    QTimer *refreshTimer;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
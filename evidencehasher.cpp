@@ -0,0 +1,196 @@
+#include "evidencehasher.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr qint64 MapWindow = 64 * 1024 * 1024;
+// More parallel readers than this only make a disk seek back and forth
+constexpr int MaxReaders = 8;
+constexpr quint32 CacheMagic = 0x444f4843; // "DOHC"
+constexpr quint32 CacheVersion = 1;
+
+struct CacheEntry {
+    qint64 size = 0;
+    qint64 modified = 0;
+    QByteArray sha256;
+};
+
+QString cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/hashcache");
+}
+
+QHash<QString, CacheEntry> loadCache()
+{
+    QHash<QString, CacheEntry> cache;
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return cache;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != CacheMagic || version != CacheVersion)
+        return cache;
+    cache.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        QString filePath;
+        CacheEntry entry;
+        stream >> filePath >> entry.size >> entry.modified >> entry.sha256;
+        if (stream.status() != QDataStream::Ok)
+            break;
+        cache.insert(filePath, entry);
+    }
+    return cache;
+}
+
+void saveCache(const QHash<QString, CacheEntry> &cache)
+{
+    QDir().mkpath(QFileInfo(cachePath()).absolutePath());
+    QSaveFile file(cachePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Could not write hash cache: %s", qPrintable(file.errorString()));
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << CacheMagic << CacheVersion << quint32(cache.size());
+    for (auto it = cache.cbegin(); it != cache.cend(); ++it)
+        stream << it.key() << it->size << it->modified << it->sha256;
+    if (!file.commit())
+        qWarning("Could not write hash cache: %s", qPrintable(file.errorString()));
+}
+
+// Streams the file through the hash one mapped window at a time. Files that
+// cannot be mapped (some network file systems) are read instead.
+QByteArray hashFile(const QString &filePath, const QThread *thread, std::atomic<qint64> &hashedBytes,
+                    QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorString = file.errorString();
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    const qint64 size = file.size();
+    for (qint64 offset = 0; offset < size; offset += MapWindow) {
+        if (thread->isInterruptionRequested())
+            return QByteArray();
+        const qint64 length = qMin(MapWindow, size - offset);
+        if (uchar *data = file.map(offset, length)) {
+#if defined(Q_OS_UNIX)
+            // The window is read once, front to back: ask for aggressive read-ahead
+            const quintptr pageSize = quintptr(sysconf(_SC_PAGESIZE));
+            const quintptr pageStart = quintptr(data) & ~(pageSize - 1);
+            madvise(reinterpret_cast<void *>(pageStart), size_t(quintptr(data) + length - pageStart), MADV_SEQUENTIAL);
+#endif
+            hash.addData(QByteArrayView(reinterpret_cast<const char *>(data), length));
+            file.unmap(data);
+        } else {
+            const QByteArray bytes = file.seek(offset) ? file.read(length) : QByteArray();
+            if (bytes.size() != length) {
+                *errorString = file.errorString();
+                return QByteArray();
+            }
+            hash.addData(bytes);
+        }
+        hashedBytes += length;
+    }
+    return hash.result().toHex();
+}
+
+} // namespace
+
+EvidenceHasher::EvidenceHasher(const QStringList &filePaths, QObject *parent)
+    : QThread(parent)
+{
+    results.reserve(filePaths.size());
+    for (const QString &filePath : filePaths) {
+        FileHash hash;
+        hash.filePath = filePath;
+        results.append(hash);
+    }
+}
+
+QList<QList<int>> EvidenceHasher::duplicateGroups() const
+{
+    QHash<QByteArray, QList<int>> byContent;
+    for (int i = 0; i < results.size(); ++i) {
+        const FileHash &hash = results.at(i);
+        if (!hash.sha256.isEmpty())
+            byContent[QByteArray::number(hash.size) + ':' + hash.sha256].append(i);
+    }
+    QList<QList<int>> groups;
+    for (const QList<int> &group : std::as_const(byContent)) {
+        if (group.size() > 1)
+            groups.append(group);
+    }
+    return groups;
+}
+
+void EvidenceHasher::run()
+{
+    // Only files that changed since they were last hashed are read
+    QHash<QString, CacheEntry> cache = loadCache();
+    QList<int> pending;
+    qint64 totalBytes = 0;
+    for (int i = 0; i < results.size(); ++i) {
+        FileHash &hash = results[i];
+        const QFileInfo info(hash.filePath);
+        if (!info.isFile()) {
+            hash.error = QStringLiteral("File not found");
+            continue;
+        }
+        hash.size = info.size();
+        hash.modified = info.lastModified().toMSecsSinceEpoch();
+        const auto it = cache.constFind(hash.filePath);
+        if (it != cache.cend() && it->size == hash.size && it->modified == hash.modified) {
+            hash.sha256 = it->sha256;
+        } else {
+            pending.append(i);
+            totalBytes += hash.size;
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [this](int a, int b) { return results.at(a).size > results.at(b).size; });
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), MaxReaders));
+    std::atomic<qint64> hashedBytes{0};
+    // Each reader writes only its own entry; the list itself is not resized meanwhile
+    FileHash *entries = results.data();
+    for (int i : std::as_const(pending)) {
+        pool.start([this, entries, i, &hashedBytes]() {
+            FileHash &hash = entries[i];
+            hash.sha256 = hashFile(hash.filePath, this, hashedBytes, &hash.error);
+        });
+    }
+    while (!pool.waitForDone(100))
+        emit progress(hashedBytes, totalBytes);
+    emit progress(hashedBytes, totalBytes);
+
+    // What was hashed before a cancel is kept for next time
+    for (int i : std::as_const(pending)) {
+        const FileHash &hash = results.at(i);
+        if (!hash.sha256.isEmpty())
+            cache.insert(hash.filePath, {hash.size, hash.modified, hash.sha256});
+    }
+    saveCache(cache);
+    hashResult = isInterruptionRequested() ? Cancelled : Hashed;
+}
@@ -0,0 +1,55 @@
+#ifndef EVIDENCEHASHER_H
+#define EVIDENCEHASHER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QStringList>
+#include <QThread>
+
+// The SHA-256 of one evidence file, with the size and modification time it
+// was taken at.
+struct FileHash
+{
+    QString filePath;
+    qint64 size = -1;
+    qint64 modified = -1;  // ms since the epoch
+    QByteArray sha256;     // lowercase hex; empty if the file could not be read
+    QString error;         // why the file could not be read
+};
+
+// Hashes evidence files on its own thread. Files are read through memory
+// mappings, a window at a time, by a pool of readers working on different
+// files at once, so fast disks are kept busy; the largest files start first
+// so one big recording does not run on alone at the end.
+//
+// Results are remembered in a cache by path, size and modification time, and
+// a file that has not changed since it was last hashed is not read again.
+// Duplicates are found from the hashes, among files of equal size only.
+// Cancel with requestInterruption(); result() is valid once finished() is emitted.
+class EvidenceHasher : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Result { Hashed, Cancelled };
+
+    explicit EvidenceHasher(const QStringList &filePaths, QObject *parent = nullptr);
+
+    Result result() const { return hashResult; }
+    // One entry per requested file, in the order given.
+    const QList<FileHash> &hashes() const { return results; }
+    // Indexes into hashes() of files that are byte-identical, one list per set.
+    QList<QList<int>> duplicateGroups() const;
+
+signals:
+    void progress(qint64 bytesHashed, qint64 totalBytes);
+
+protected:
+    void run() override;
+
+private:
+    QList<FileHash> results;
+    Result hashResult = Cancelled;
+};
+
+#endif // EVIDENCEHASHER_H
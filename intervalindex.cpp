@@ -0,0 +1,80 @@
+#include "intervalindex.h"
+
+#include <algorithm>
+
+void IntervalIndex::build(const QList<Interval> &intervals)
+{
+    clear();
+    byStart.reserve(intervals.size());
+    byEnd.reserve(intervals.size());
+    root = buildNode(intervals);
+}
+
+void IntervalIndex::clear()
+{
+    nodes.clear();
+    byStart.clear();
+    byEnd.clear();
+    root = -1;
+}
+
+// The center is the median of all endpoints, so at most half of the intervals
+// lie entirely on either side and the tree is O(log n) deep.
+int IntervalIndex::buildNode(QList<Interval> intervals)
+{
+    if (intervals.isEmpty())
+        return -1;
+
+    QList<qint64> endpoints;
+    endpoints.reserve(intervals.size() * 2);
+    for (const Interval &interval : std::as_const(intervals))
+        endpoints << interval.start << interval.end;
+    const auto median = endpoints.begin() + endpoints.size() / 2;
+    std::nth_element(endpoints.begin(), median, endpoints.end());
+
+    Node node;
+    node.center = *median;
+    QList<Interval> left, right, here;
+    for (const Interval &interval : std::as_const(intervals)) {
+        if (interval.end < node.center)
+            left.append(interval);
+        else if (interval.start > node.center)
+            right.append(interval);
+        else
+            here.append(interval);
+    }
+    intervals = QList<Interval>();
+
+    node.first = int(byStart.size());
+    node.count = int(here.size());
+    std::sort(here.begin(), here.end(), [](const Interval &a, const Interval &b) { return a.start < b.start; });
+    byStart.append(here);
+    std::sort(here.begin(), here.end(), [](const Interval &a, const Interval &b) { return a.end > b.end; });
+    byEnd.append(here);
+
+    const int index = int(nodes.size());
+    nodes.append(node);
+    const int leftChild = buildNode(std::move(left));
+    const int rightChild = buildNode(std::move(right));
+    nodes[index].left = leftChild;
+    nodes[index].right = rightChild;
+    return index;
+}
+
+void IntervalIndex::stab(qint64 point, QList<int> *ids) const
+{
+    int current = root;
+    while (current >= 0) {
+        const Node &node = nodes.at(current);
+        if (point < node.center) {
+            // Every interval here ends at or after the center; only the start matters
+            for (int i = node.first; i < node.first + node.count && byStart.at(i).start <= point; ++i)
+                ids->append(byStart.at(i).id);
+            current = node.left;
+        } else {
+            for (int i = node.first; i < node.first + node.count && byEnd.at(i).end >= point; ++i)
+                ids->append(byEnd.at(i).id);
+            current = point > node.center ? node.right : -1;
+        }
+    }
+}
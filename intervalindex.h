@@ -0,0 +1,44 @@
+#ifndef INTERVALINDEX_H
+#define INTERVALINDEX_H
+
+#include <QList>
+
+// Static centered interval tree answering "which intervals contain this point"
+// in O(log n + k). Each node holds the intervals that contain its center, once
+// sorted by start and once by end, so a query only walks the part of each list
+// that matches. Intervals are closed: both ends are included.
+class IntervalIndex
+{
+public:
+    struct Interval {
+        qint64 start = 0;
+        qint64 end = 0;
+        int id = 0;
+    };
+
+    void build(const QList<Interval> &intervals);
+    void clear();
+    bool isEmpty() const { return nodes.isEmpty(); }
+    int size() const { return int(byStart.size()); }
+
+    // Appends the ids of the intervals containing `point`, in no particular order.
+    void stab(qint64 point, QList<int> *ids) const;
+
+private:
+    struct Node {
+        qint64 center = 0;
+        int left = -1;
+        int right = -1;
+        int first = 0; // the node's intervals in byStart and byEnd
+        int count = 0;
+    };
+
+    int buildNode(QList<Interval> intervals);
+
+    QList<Node> nodes;
+    QList<Interval> byStart;
+    QList<Interval> byEnd;
+    int root = -1;
+};
+
+#endif // INTERVALINDEX_H
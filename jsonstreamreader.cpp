@@ -0,0 +1,234 @@
+#include "jsonstreamreader.h"
+
+#include <QIODevice>
+
+namespace {
+
+constexpr qint64 ChunkSize = 256 * 1024;
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+void appendUtf8(QByteArray &out, char32_t codePoint)
+{
+    if (codePoint < 0x80) {
+        out.append(char(codePoint));
+    } else if (codePoint < 0x800) {
+        out.append(char(0xC0 | (codePoint >> 6)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.append(char(0xE0 | (codePoint >> 12)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (codePoint >> 18)));
+        out.append(char(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+} // namespace
+
+JsonStreamReader::JsonStreamReader(QIODevice *device)
+    : device(device)
+{
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    for (;;) {
+        if (pos >= buffer.size() && !fill())
+            return EndOfDocument;
+
+        switch (buffer.at(pos)) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case ',':
+        case ':':
+            ++pos;
+            continue;
+        case '{':
+            ++pos;
+            return BeginObject;
+        case '}':
+            ++pos;
+            return EndObject;
+        case '[':
+            ++pos;
+            return BeginArray;
+        case ']':
+            ++pos;
+            return EndArray;
+        case '"':
+            ++pos;
+            return readString() ? String : Invalid;
+        default:
+            return readLiteral();
+        }
+    }
+}
+
+bool JsonStreamReader::skipValue(Token first)
+{
+    if (first != BeginObject && first != BeginArray)
+        return first != Invalid && first != EndOfDocument;
+
+    int depth = 1;
+    while (depth > 0) {
+        switch (next()) {
+        case BeginObject:
+        case BeginArray:
+            ++depth;
+            break;
+        case EndObject:
+        case EndArray:
+            --depth;
+            break;
+        case Invalid:
+            return false;
+        case EndOfDocument:
+            fail(QStringLiteral("Unexpected end of document"));
+            return false;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+bool JsonStreamReader::fill()
+{
+    consumedBefore += buffer.size();
+    pos = 0;
+    buffer.resize(ChunkSize);
+    const qint64 bytesRead = device->read(buffer.data(), ChunkSize);
+    buffer.resize(qMax<qint64>(bytesRead, 0));
+    return bytesRead > 0;
+}
+
+bool JsonStreamReader::nextByte(char &c)
+{
+    if (pos >= buffer.size() && !fill())
+        return false;
+    c = buffer.at(pos++);
+    return true;
+}
+
+bool JsonStreamReader::readString()
+{
+    utf8.clear();
+    for (;;) {
+        if (pos >= buffer.size() && !fill()) {
+            fail(QStringLiteral("Unterminated string"));
+            return false;
+        }
+
+        // Copy the run of plain bytes up to the next quote or escape in one go
+        const char *data = buffer.constData();
+        const qsizetype start = pos;
+        while (pos < buffer.size() && data[pos] != '"' && data[pos] != '\\')
+            ++pos;
+        utf8.append(data + start, pos - start);
+        if (pos >= buffer.size())
+            continue;
+
+        if (data[pos++] == '"') {
+            value = QString::fromUtf8(utf8);
+            return true;
+        }
+
+        char escape;
+        if (!nextByte(escape)) {
+            fail(QStringLiteral("Unterminated string"));
+            return false;
+        }
+        switch (escape) {
+        case '"': utf8.append('"'); break;
+        case '\\': utf8.append('\\'); break;
+        case '/': utf8.append('/'); break;
+        case 'b': utf8.append('\b'); break;
+        case 'f': utf8.append('\f'); break;
+        case 'n': utf8.append('\n'); break;
+        case 'r': utf8.append('\r'); break;
+        case 't': utf8.append('\t'); break;
+        case 'u': {
+            auto readCodeUnit = [this](char32_t &unit) {
+                unit = 0;
+                for (int i = 0; i < 4; ++i) {
+                    char c;
+                    if (!nextByte(c) || hexValue(c) < 0)
+                        return false;
+                    unit = (unit << 4) | char32_t(hexValue(c));
+                }
+                return true;
+            };
+            char32_t unit;
+            if (!readCodeUnit(unit)) {
+                fail(QStringLiteral("Invalid \\u escape"));
+                return false;
+            }
+            if (unit >= 0xD800 && unit < 0xDC00) {
+                char backslash, u;
+                char32_t low;
+                if (!nextByte(backslash) || !nextByte(u) || backslash != '\\' || u != 'u'
+                    || !readCodeUnit(low) || low < 0xDC00 || low >= 0xE000) {
+                    fail(QStringLiteral("Unpaired surrogate in \\u escape"));
+                    return false;
+                }
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUtf8(utf8, unit);
+            break;
+        }
+        default:
+            fail(QStringLiteral("Invalid escape sequence"));
+            return false;
+        }
+    }
+}
+
+JsonStreamReader::Token JsonStreamReader::readLiteral()
+{
+    QByteArray literal;
+    for (;;) {
+        if (pos >= buffer.size() && !fill())
+            break;
+        const char c = buffer.at(pos);
+        const bool literalChar = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                                 || c == '-' || c == '+' || c == '.';
+        if (!literalChar)
+            break;
+        literal.append(c);
+        ++pos;
+    }
+
+    value = QString::fromLatin1(literal);
+    if (literal == "true" || literal == "false")
+        return Bool;
+    if (literal == "null")
+        return Null;
+    bool isNumber = false;
+    literal.toDouble(&isNumber);
+    if (isNumber)
+        return Number;
+    return fail(literal.isEmpty() ? QStringLiteral("Unexpected character at offset %1").arg(bytesConsumed())
+                                  : QStringLiteral("Invalid literal '%1'").arg(value));
+}
+
+JsonStreamReader::Token JsonStreamReader::fail(const QString &message)
+{
+    if (error.isEmpty())
+        error = message;
+    return Invalid;
+}
@@ -0,0 +1,56 @@
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+
+// Pull tokenizer for JSON read from a device in fixed-size chunks, so a document
+// can be processed without holding the whole file (or a QJsonDocument) in memory.
+// Structure is left to the caller: object keys are reported as String tokens and
+// the ',' and ':' separators are not validated.
+class JsonStreamReader
+{
+public:
+    enum Token {
+        Invalid,
+        EndOfDocument,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        String,
+        Number,
+        Bool,
+        Null
+    };
+
+    explicit JsonStreamReader(QIODevice *device);
+
+    Token next();
+    // Skips the remainder of a value whose first token has just been read.
+    bool skipValue(Token first);
+
+    // Text of the last String token, or the literal of the last Number/Bool.
+    const QString &stringValue() const { return value; }
+    QString errorString() const { return error; }
+    qint64 bytesConsumed() const { return consumedBefore + pos; }
+
+private:
+    bool fill();
+    bool nextByte(char &c);
+    bool readString();
+    Token readLiteral();
+    Token fail(const QString &message);
+
+    QIODevice *device;
+    QByteArray buffer;
+    QByteArray utf8;
+    qsizetype pos = 0;
+    qint64 consumedBefore = 0;
+    QString value;
+    QString error;
+};
+
+#endif // JSONSTREAMREADER_H
@@ -5,11 +5,21 @@
 #include <QMediaPlayer>
 #include <QShortcut>
 
+#include "casedata.h"
+#include "casejournal.h"
+#include "casesearchindex.h"
+#include "intervalindex.h"
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
 // Forward declarations for UI elements and system classes
 class QSplitter;
-class QTextEdit;
 class QLineEdit;
-class QTableWidget;
+class QTableView;
+class QListView;
+class QAbstractItemView;
+class QModelIndex;
 class QVideoWidget;
 class QPushButton;
 class QTabWidget;
@@ -19,6 +29,29 @@ class QMenu;
 class QAction;
 class QStackedWidget;
 class QAudioOutput;
+class QProgressBar;
+class QListWidget;
+class QListWidgetItem;
+class QCheckBox;
+class CaseTableModel;
+class CaseTableProxyModel;
+class CaseLoader;
+class TiledImageView;
+class NotesEditor;
+class MediaThumbnailer;
+class MediaLibraryModel;
+class VideoFrameCache;
+class CaseAutosave;
+class CaseCatalog;
+class CsvExporter;
+class CsvImporter;
+class EvidenceHasher;
+class VideoAnalyzer;
+class CaseMerger;
+class DiagnosticsDialog;
+struct CsvDialect;
+class QTimer;
+class QUndoStack;
 
 
 class MainWindow : public QMainWindow
@@ -31,6 +64,7 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private slots:
     // File Operations
@@ -39,13 +73,37 @@ private slots:
     bool saveCaseAs();
     void openCase();
     void updateWindowTitle();
+    void caseFieldLoaded(const QString &key, const QString &value);
+    void caseRowsLoaded(int table, const QStringList &cells);
+    void caseTableLoaded(int table, const CaseTable &contents);
+    void caseLoadProgress(qint64 bytesRead, qint64 totalBytes);
+    void caseLoadFinished();
+    void compactionFinished();
+    void autosaveCase();
+    void restoreSession();
+    void offerCaseRecovery();
+    void mergeCases();
+    void chooseCatalogFolder();
+    void findEntityInCatalog();
+    void caseMergeFinished();
 
     // Media Operations
     void openMediaFile(); // Renamed from openVideoFile
+    void addMediaToLibrary();
+    void addMediaFolderToLibrary();
+    void openLibraryMedia(const QModelIndex &index);
+    void editMediaDescription();
+    void hashEvidenceFiles();
+    void evidenceHashingFinished();
+    void analyzeVideo();
+    void videoAnalysisFinished();
     void playPause();
     void mediaPositionChanged(qint64 position);
     void mediaDurationChanged(qint64 duration);
+    void refreshMediaPosition();
     void setMediaPosition(int position);
+    void stepFrame(int direction);
+    void seekToNoteTimestamp(qint64 position);
     void updatePlayPauseButton(QMediaPlayer::PlaybackState state);
 
     // Audio Controls
@@ -59,9 +117,24 @@ private slots:
     void addResourceRow();
     void showTableContextMenu(const QPoint &pos);
     void removeSelectedTableRow();
+    void showEditorContextMenu(const QPoint &pos);
+
+    // Import Operations
+    void importTableFromCsv();
+    void csvImportFinished();
+
+    // Search
+    void searchCase();
+    void showSearchResult(QListWidgetItem *item);
 
     // Export Operations
     void exportTableToCsv();
+    void exportAllTablesToCsv();
+    void csvExportProgress(qint64 rowsWritten, qint64 totalRows);
+    void csvExportFinished();
+
+    // Help
+    void showDiagnostics();
 
 private:
     void setupUi();
@@ -71,14 +144,36 @@ private:
 
     // UI Helper Functions
     QString formatTime(qint64 timeMilliSeconds);
+    void reportPlaybackCounters();
     void setWindowModified(bool modified);
     bool maybeSave();
     void clearAllFields();
     void setMediaControlsEnabled(bool enabled);
+    void setCaseLoading(bool loading);
+    void rebuildEventIndex();
+    void updateActiveEvents(qint64 position);
+    void applyActiveEventsFilter();
+    void setEventRowHidden(int row, bool hidden);
+    void updateExportActions();
+    void openMedia(const QString &filePath);
+    void createMediaPlayer();
+    qint64 playbackPosition() const;
+    void addMediaFiles(const QStringList &filePaths);
+    void addDetectedEvents(const QStringList &cells);
 
     // Data Persistence Functions
+    CaseTableModel *tableModel(int table) const;
+    QAbstractItemView *tableView(int table) const;
+    CaseData caseSnapshot() const;
+    QString caseFieldText(CaseEdit::Field field) const;
+    void replayJournal(const QString &casePath);
+    void startCompaction();
+    void finishCompaction();
     bool writeCaseData(const QString &filePath);
     bool readCaseData(const QString &filePath);
+    CsvDialect csvDialect() const;
+    QString csvFileSuffix() const;
+    void startCsvExport(const QList<int> &tables, const QStringList &filePaths);
 
     // --- Main Layout ---
     QSplitter *mainSplitter;
@@ -86,12 +181,17 @@ private:
     // --- Left Panel: Media Player ---
     QWidget *mediaPanel;
     QStackedWidget *mediaStack; // To switch between video and image
-    QMediaPlayer *mediaPlayer;
-    QAudioOutput *audioOutput; // <-- FIX for no sound
-    QVideoWidget *videoWidget;
-    QLabel *imageDisplayLabel; // For viewing images
+    // Created with the first video, see createMediaPlayer()
+    QMediaPlayer *mediaPlayer = nullptr;
+    QAudioOutput *audioOutput = nullptr;
+    QVideoWidget *videoWidget = nullptr;
+    QLabel *imageDisplayLabel; // Placeholder while no media is open
+    TiledImageView *imageView; // For viewing images
+    VideoFrameCache *frameCache = nullptr; // Decoded frames around the playhead
+    int scrubPosition = 0;
 
     QPushButton *openMediaButton;
+    QPushButton *analyzeVideoButton;
     QPushButton *playPauseButton;
     QSlider *mediaPositionSlider;
     QLabel *mediaTimeLabel;
@@ -102,40 +202,139 @@ private:
     QWidget *thePanel;
     QLineEdit *caseNameEdit;
     QLineEdit *subjectTargetEdit;
+    QLineEdit *searchEdit;
+    QListWidget *searchResults;
     QTabWidget *theTabs;
 
     // -- Tab Widgets
     QWidget *notesTab;
-    QTextEdit *notesTextEdit;
+    NotesEditor *notesTextEdit;
     QPushButton *addTimestampButton;
 
     QWidget *entitiesTab;
-    QTableWidget *entitiesTable;
+    QTableView *entitiesTable;
+    CaseTableModel *entitiesModel;
+    CaseTableProxyModel *entitiesProxy;
     QPushButton *addEntityButton;
 
     QWidget *eventsTab;
-    QTableWidget *eventsTable;
+    QTableView *eventsTable;
+    CaseTableModel *eventsModel;
+    CaseTableProxyModel *eventsProxy;
+    QCheckBox *activeEventsOnlyCheck;
     QPushButton *addEventButton;
 
     QWidget *resourcesTab;
-    QTableWidget *resourcesTable;
+    QTableView *resourcesTable;
+    CaseTableModel *resourcesModel;
+    CaseTableProxyModel *resourcesProxy;
     QPushButton *addResourceButton;
 
+    QWidget *mediaTab;
+    QListView *mediaLibraryView;
+    CaseTableModel *mediaModel;
+    MediaLibraryModel *mediaLibraryModel;
+    MediaThumbnailer *mediaThumbnailer;
+    QPushButton *addMediaButton;
+    QPushButton *addMediaFolderButton;
+
+    QWidget *hashesTab;
+    QTableView *hashesTable;
+    CaseTableModel *hashesModel;
+    CaseTableProxyModel *hashesProxy;
+    QPushButton *hashEvidenceButton;
+
     // --- Menu Bar and Actions ---
     QMenu *fileMenu;
     QMenu *exportMenu;
+    QMenu *importMenu;
+    QMenu *editMenu;
+    QMenu *helpMenu;
     QAction *newCaseAction;
     QAction *openCaseAction;
     QAction *saveCaseAction;
     QAction *saveCaseAsAction;
+    QAction *journaledSaveAction;
+    QAction *reopenLastCaseAction;
+    QAction *catalogFolderAction;
+    QAction *autosaveAction;
+    QAction *mergeCasesAction;
+    QAction *mergeFoldCaseAction;
+    QAction *mergeWhitespaceAction;
     QAction *exitAction;
+    QAction *undoAction;
+    QAction *redoAction;
     QAction *exportEntitiesAction;
     QAction *exportEventsAction;
     QAction *exportResourcesAction;
+    QAction *exportAllTablesAction;
+    QAction *importEntitiesAction;
+    QAction *importEventsAction;
+    QAction *importResourcesAction;
+    QAction *csvCommaAction;
+    QAction *csvSemicolonAction;
+    QAction *csvTabAction;
+    QAction *csvQuoteAllAction;
+    QAction *csvGzipAction;
+    QAction *diagnosticsAction;
+    QAction *dumpTraceAction;
+
+    // --- Status Bar ---
+    QProgressBar *loadProgressBar;
+    QPushButton *cancelLoadButton;
+    QProgressBar *exportProgressBar;
+    QPushButton *cancelExportButton;
+    QProgressBar *hashProgressBar;
+    QPushButton *cancelHashButton;
+    QProgressBar *analysisProgressBar;
+    QPushButton *cancelAnalysisButton;
+    QProgressBar *mergeProgressBar;
+    QPushButton *cancelMergeButton;
 
     // --- State and Data ---
     QString currentCaseFile;
+    QString loadingCaseFile;
+    CaseLoader *caseLoader = nullptr;
+    CsvExporter *csvExporter = nullptr;
+    CsvImporter *csvImporter = nullptr;
+    EvidenceHasher *evidenceHasher = nullptr;
+    VideoAnalyzer *videoAnalyzer = nullptr;
+    QUrl analyzedVideo;
+    QStringList pendingDetectedEvents; // checked while an import replaces the events table
+    CaseMerger *caseMerger = nullptr;
+    DiagnosticsDialog *diagnosticsDialog = nullptr;
+    int importingTable = -1;
+    QUndoStack *undoStack;
+    CaseJournal caseJournal;
+    CaseSearchIndex *searchIndex;
+    IntervalIndex eventIndex;
+    bool eventIndexValid = false;
+    QList<int> activeEventRows;
+    QFutureWatcher<QString> *compactionWatcher;
+    QString compactingCaseFile;
+    qint64 compactedJournalBytes = 0;
+    CaseAutosave *caseAutosave;
+    CaseCatalog *caseCatalog;
+    QTimer *autosaveTimer;
+    QString recoveredCaseFile;
+    bool recoveringCase = false;
+    bool reopeningLastCase = false;
     bool isMuted = false;
+
+    // --- Playback position refresh ---
+    struct PlaybackCounters {
+        qint64 positionSignals = 0;
+        qint64 refreshes = 0;
+        qint64 labelUpdates = 0;
+        qint64 refreshNanoseconds = 0;
+        qint64 maxRefreshNanoseconds = 0;
+    };
+    QTimer *positionRefreshTimer;
+    qint64 pendingMediaPosition = 0;
+    qint64 shownPositionSecond = -1;
+    qint64 shownDurationSecond = -1;
+    PlaybackCounters playbackCounters;
+    QElapsedTimer playbackCounterWindow;
 };
 
 #endif // MAINWINDOW_H
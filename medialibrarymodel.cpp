@@ -0,0 +1,65 @@
+#include "medialibrarymodel.h"
+#include "mediathumbnailer.h"
+
+#include <QApplication>
+#include <QFileInfo>
+#include <QIcon>
+#include <QStyle>
+
+MediaLibraryModel::MediaLibraryModel(MediaThumbnailer *thumbnailer, QObject *parent)
+    : QIdentityProxyModel(parent), thumbnailer(thumbnailer)
+{
+    connect(thumbnailer, &MediaThumbnailer::thumbnailReady, this, &MediaLibraryModel::thumbnailReady);
+    connect(this, &QAbstractItemModel::modelReset, this, [this]() { waiting.clear(); });
+}
+
+QString MediaLibraryModel::filePath(const QModelIndex &index) const
+{
+    return index.isValid() ? index.siblingAtColumn(0).data(Qt::EditRole).toString() : QString();
+}
+
+QVariant MediaLibraryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.column() != 0)
+        return QIdentityProxyModel::data(index, role);
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QFileInfo(filePath(index)).fileName();
+    case Qt::ToolTipRole: {
+        const QString description = index.siblingAtColumn(1).data().toString();
+        return description.isEmpty() ? filePath(index) : filePath(index) + "\n" + description;
+    }
+    case Qt::DecorationRole: {
+        const QString path = filePath(index);
+        const QImage image = thumbnailer->thumbnail(path);
+        if (!image.isNull())
+            return image;
+        if (!thumbnailer->hasFailed(path)) {
+            QList<QPersistentModelIndex> &indexes = waiting[path];
+            if (!indexes.contains(index))
+                indexes.append(QPersistentModelIndex(index));
+        }
+        // A stand-in of the same kind until the thumbnail is ready
+        const bool video = MediaThumbnailer::mediaKind(path) == MediaThumbnailer::Video;
+        return QApplication::style()->standardIcon(video ? QStyle::SP_MediaPlay : QStyle::SP_FileIcon);
+    }
+    default:
+        return QIdentityProxyModel::data(index, role);
+    }
+}
+
+Qt::ItemFlags MediaLibraryModel::flags(const QModelIndex &index) const
+{
+    // Files are added and removed rather than renamed in place
+    return QIdentityProxyModel::flags(index) & ~Qt::ItemIsEditable;
+}
+
+void MediaLibraryModel::thumbnailReady(const QString &filePath)
+{
+    const QList<QPersistentModelIndex> indexes = waiting.take(filePath);
+    for (const QPersistentModelIndex &index : indexes) {
+        if (index.isValid())
+            emit dataChanged(index, index, {Qt::DecorationRole});
+    }
+}
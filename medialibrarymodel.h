@@ -0,0 +1,34 @@
+#ifndef MEDIALIBRARYMODEL_H
+#define MEDIALIBRARYMODEL_H
+
+#include <QHash>
+#include <QIdentityProxyModel>
+#include <QPersistentModelIndex>
+
+class MediaThumbnailer;
+
+// Presents the case's media table (file path, description) as a thumbnail
+// list: the first column shows the file name with its thumbnail as decoration.
+// Thumbnails are only asked for when a view shows the item, so opening a case
+// with thousands of files starts no work for the ones scrolled out of sight.
+class MediaLibraryModel : public QIdentityProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit MediaLibraryModel(MediaThumbnailer *thumbnailer, QObject *parent = nullptr);
+
+    QString filePath(const QModelIndex &index) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+private:
+    void thumbnailReady(const QString &filePath);
+
+    MediaThumbnailer *thumbnailer;
+    // Items shown before their thumbnail was ready, to repaint once it is
+    mutable QHash<QString, QList<QPersistentModelIndex>> waiting;
+};
+
+#endif // MEDIALIBRARYMODEL_H
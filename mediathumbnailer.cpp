@@ -0,0 +1,310 @@
+#include "mediathumbnailer.h"
+#include "perftrace.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMediaPlayer>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVideoSink>
+#include <QtEndian>
+
+#include <memory>
+
+namespace {
+
+constexpr qsizetype ThumbnailCacheBytes = 64 * 1024 * 1024;
+constexpr qint64 FingerprintBlock = 64 * 1024;
+constexpr int MaxFrameGrabs = 2;
+constexpr int FrameGrabTimeout = 15 * 1000;
+// The frame is taken a tenth of the way in, which skips most black leaders and
+// title cards, but never further than this into a long recording
+constexpr qint64 MaxFramePosition = 10 * 1000;
+constexpr quint32 IndexMagic = 0x444f5449; // "DOTI"
+constexpr quint32 IndexVersion = 1;
+
+QImage fitThumbnail(const QImage &image)
+{
+    const int size = MediaThumbnailer::ThumbnailSize;
+    if (image.width() <= size && image.height() <= size)
+        return image;
+    return image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+// A scaled read lets JPEG decode at reduced resolution instead of in full
+QImage readImageThumbnail(const QString &filePath)
+{
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+    const QSize size = reader.size();
+    if (size.isValid() && !size.isEmpty()) {
+        const int side = MediaThumbnailer::ThumbnailSize;
+        reader.setScaledSize(size.scaled(side, side, Qt::KeepAspectRatio).boundedTo(size));
+    }
+    return fitThumbnail(reader.read());
+}
+
+void saveThumbnail(const QImage &image, const QString &cachePath)
+{
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "JPG", 85) || !file.commit())
+        qWarning("Could not write thumbnail %s: %s", qPrintable(cachePath), qPrintable(file.errorString()));
+}
+
+} // namespace
+
+const QStringList MediaThumbnailer::VideoPatterns = {"*.mp4", "*.avi", "*.mov", "*.mkv", "*.wmv"};
+const QStringList MediaThumbnailer::ImagePatterns = {"*.png", "*.jpg", "*.jpeg", "*.bmp", "*.gif"};
+
+MediaThumbnailer::MediaThumbnailer(QObject *parent)
+    : QObject(parent), thumbnails(ThumbnailCacheBytes)
+{
+    // Thumbnailing shares the disk and cores with everything else, so keep it small
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+    cacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/thumbnails");
+    QDir().mkpath(cacheDirectory);
+    loadIndex();
+}
+
+MediaThumbnailer::~MediaThumbnailer()
+{
+    // Lookups post their results here, so they have to end first
+    pool.clear();
+    pool.waitForDone();
+    saveIndex();
+}
+
+MediaThumbnailer::MediaKind MediaThumbnailer::mediaKind(const QString &filePath)
+{
+    const QString pattern = "*." + QFileInfo(filePath).suffix().toLower();
+    if (VideoPatterns.contains(pattern))
+        return Video;
+    if (ImagePatterns.contains(pattern))
+        return Image;
+    return Unsupported;
+}
+
+QImage MediaThumbnailer::thumbnail(const QString &filePath)
+{
+    if (const QImage *image = thumbnails.object(filePath))
+        return *image;
+    if (pending.contains(filePath) || failed.contains(filePath))
+        return QImage();
+
+    pending.insert(filePath);
+    MediaThumbnailer *thumbnailer = this;
+    const int requestGeneration = generation;
+    pool.start([thumbnailer, filePath, requestGeneration]() {
+        const QByteArray key = thumbnailer->contentKey(filePath);
+        QImage image;
+        if (!key.isEmpty()) {
+            const QString cached = thumbnailer->cachePath(key);
+            image.load(cached);
+            if (image.isNull() && mediaKind(filePath) == Image) {
+                image = readImageThumbnail(filePath);
+                if (!image.isNull())
+                    saveThumbnail(image, cached);
+            }
+        }
+        QMetaObject::invokeMethod(thumbnailer, [thumbnailer, requestGeneration, filePath, key, image]() {
+            thumbnailer->lookupFinished(requestGeneration, filePath, key, image);
+        }, Qt::QueuedConnection);
+    });
+    return QImage();
+}
+
+void MediaThumbnailer::cancelPending()
+{
+    // Lookups already running finish and are then ignored
+    pool.clear();
+    ++generation;
+    pending.clear();
+    frameQueue.clear();
+}
+
+// Identifies a file by its content without reading all of it. Runs on the pool.
+QByteArray MediaThumbnailer::contentKey(const QString &filePath)
+{
+    const QFileInfo info(filePath);
+    if (!info.isFile())
+        return QByteArray();
+    const qint64 size = info.size();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&indexMutex);
+        const auto it = index.constFind(filePath);
+        if (it != index.cend() && it->size == size && it->modified == modified)
+            return it->key;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    char sizeBytes[8];
+    qToLittleEndian<quint64>(quint64(size), sizeBytes);
+    hash.addData(QByteArrayView(sizeBytes, sizeof(sizeBytes)));
+    hash.addData(file.read(FingerprintBlock));
+    if (size > FingerprintBlock && file.seek(qMax(FingerprintBlock, size - FingerprintBlock)))
+        hash.addData(file.read(FingerprintBlock));
+    const QByteArray key = hash.result().toHex();
+
+    QMutexLocker locker(&indexMutex);
+    index.insert(filePath, {size, modified, key});
+    indexChanged = true;
+    return key;
+}
+
+QString MediaThumbnailer::cachePath(const QByteArray &key) const
+{
+    return cacheDirectory + QLatin1Char('/') + QString::fromLatin1(key) + QStringLiteral(".jpg");
+}
+
+void MediaThumbnailer::lookupFinished(int requestGeneration, const QString &filePath, const QByteArray &key,
+                                      const QImage &image)
+{
+    if (requestGeneration != generation)
+        return;
+    if (image.isNull() && !key.isEmpty() && mediaKind(filePath) == Video) {
+        frameQueue.append({filePath, key});
+        startFrameGrabs();
+        return;
+    }
+    pending.remove(filePath);
+    if (image.isNull())
+        failed.insert(filePath);
+    else
+        thumbnails.insert(filePath, new QImage(image), image.sizeInBytes());
+    emit thumbnailReady(filePath);
+}
+
+void MediaThumbnailer::startFrameGrabs()
+{
+    while (activeFrameGrabs < MaxFrameGrabs && !frameQueue.isEmpty())
+        grabFrame(frameQueue.takeFirst());
+}
+
+// Plays the video without audio output until the sink receives a frame from
+// past the seek point. The player decodes on its own threads.
+void MediaThumbnailer::grabFrame(const FrameRequest &request)
+{
+    ++activeFrameGrabs;
+    QMediaPlayer *player = new QMediaPlayer(this);
+    QVideoSink *sink = new QVideoSink(player);
+    QTimer *timeout = new QTimer(player);
+    player->setVideoSink(sink);
+    timeout->setSingleShot(true);
+
+    const auto done = std::make_shared<bool>(false);
+    const auto target = std::make_shared<qint64>(0);
+    const int grabGeneration = generation;
+    auto finish = [this, player, done, grabGeneration, request](const QVideoFrame &frame) {
+        if (*done)
+            return;
+        *done = true;
+        player->stop();
+        player->deleteLater();
+        frameGrabbed(grabGeneration, request, frame);
+    };
+
+    connect(player, &QMediaPlayer::mediaStatusChanged, player, [player, target, finish](QMediaPlayer::MediaStatus status) {
+        if (status == QMediaPlayer::LoadedMedia) {
+            *target = player->isSeekable() ? qMin(player->duration() / 10, MaxFramePosition) : 0;
+            if (*target > 0)
+                player->setPosition(*target);
+            player->play();
+        } else if (status == QMediaPlayer::InvalidMedia || status == QMediaPlayer::EndOfMedia) {
+            finish(QVideoFrame());
+        }
+    });
+    connect(player, &QMediaPlayer::errorOccurred, player, [finish]() { finish(QVideoFrame()); });
+    connect(sink, &QVideoSink::videoFrameChanged, player, [target, finish](const QVideoFrame &frame) {
+        // Frames decoded before the seek took effect may still arrive; start times are in microseconds
+        if (frame.isValid() && (frame.startTime() < 0 || frame.startTime() >= (*target - 500) * 1000))
+            finish(frame);
+    });
+    connect(timeout, &QTimer::timeout, player, [finish]() { finish(QVideoFrame()); });
+
+    timeout->start(FrameGrabTimeout);
+    player->setSource(QUrl::fromLocalFile(request.filePath));
+}
+
+void MediaThumbnailer::frameGrabbed(int grabGeneration, const FrameRequest &request, const QVideoFrame &frame)
+{
+    PERF_TRACE_SCOPE("media.thumbnailFrame");
+    --activeFrameGrabs;
+    startFrameGrabs();
+    if (grabGeneration != generation)
+        return;
+    if (!frame.isValid()) {
+        lookupFinished(grabGeneration, request.filePath, QByteArray(), QImage());
+        return;
+    }
+
+    // Converting and scaling a full-size frame is left to the pool
+    MediaThumbnailer *thumbnailer = this;
+    const QString cached = cachePath(request.key);
+    pool.start([thumbnailer, grabGeneration, request, frame, cached]() {
+        const QImage image = fitThumbnail(frame.toImage());
+        if (!image.isNull())
+            saveThumbnail(image, cached);
+        QMetaObject::invokeMethod(thumbnailer, [thumbnailer, grabGeneration, request, image]() {
+            thumbnailer->lookupFinished(grabGeneration, request.filePath, QByteArray(), image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MediaThumbnailer::loadIndex()
+{
+    QFile file(cacheDirectory + QStringLiteral("/index"));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != IndexMagic || version != IndexVersion)
+        return;
+    index.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        QString filePath;
+        IndexEntry entry;
+        stream >> filePath >> entry.size >> entry.modified >> entry.key;
+        if (stream.status() != QDataStream::Ok)
+            break;
+        index.insert(filePath, entry);
+    }
+}
+
+void MediaThumbnailer::saveIndex()
+{
+    QMutexLocker locker(&indexMutex);
+    if (!indexChanged)
+        return;
+    // Entries for files that no longer exist are dropped as the index is rewritten
+    QSaveFile file(cacheDirectory + QStringLiteral("/index"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Could not write thumbnail index: %s", qPrintable(file.errorString()));
+        return;
+    }
+    QList<QString> paths;
+    for (auto it = index.cbegin(); it != index.cend(); ++it) {
+        if (QFileInfo::exists(it.key()))
+            paths.append(it.key());
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << IndexMagic << IndexVersion << quint32(paths.size());
+    for (const QString &filePath : std::as_const(paths)) {
+        const IndexEntry entry = index.value(filePath);
+        stream << filePath << entry.size << entry.modified << entry.key;
+    }
+    if (!file.commit())
+        qWarning("Could not write thumbnail index: %s", qPrintable(file.errorString()));
+    indexChanged = false;
+}
@@ -0,0 +1,87 @@
+#ifndef MEDIATHUMBNAILER_H
+#define MEDIATHUMBNAILER_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QVideoFrame>
+
+// Makes and caches thumbnails of the media files referenced by a case.
+//
+// Thumbnails are stored as JPEG files under the user's cache directory, named
+// after a fingerprint of the file's content (its size and the SHA-1 of its
+// first and last 64 KiB), so a renamed or copied file reuses its thumbnail and
+// an edited one gets a new one. A small index remembers the fingerprint of
+// every path by size and modification time, so a cached thumbnail is found
+// without reading the media file at all.
+//
+// Lookups, fingerprinting and image decoding run on a small thread pool. Video
+// frames come from a headless QMediaPlayer feeding a QVideoSink; those players
+// live on the GUI thread and only a couple of them run at once.
+class MediaThumbnailer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum MediaKind { Unsupported, Video, Image };
+
+    static const QStringList VideoPatterns;
+    static const QStringList ImagePatterns;
+    static constexpr int ThumbnailSize = 160;
+
+    explicit MediaThumbnailer(QObject *parent = nullptr);
+    ~MediaThumbnailer();
+
+    static MediaKind mediaKind(const QString &filePath);
+
+    // The thumbnail if it is in memory; otherwise a null image, and
+    // thumbnailReady() follows once it has been found or made.
+    QImage thumbnail(const QString &filePath);
+    bool hasFailed(const QString &filePath) const { return failed.contains(filePath); }
+    // Drops queued work; thumbnails already made stay cached.
+    void cancelPending();
+
+signals:
+    // Also emitted when no thumbnail could be made, see hasFailed().
+    void thumbnailReady(const QString &filePath);
+
+private:
+    struct IndexEntry {
+        qint64 size = 0;
+        qint64 modified = 0;
+        QByteArray key;
+    };
+    struct FrameRequest {
+        QString filePath;
+        QByteArray key;
+    };
+
+    QByteArray contentKey(const QString &filePath);
+    QString cachePath(const QByteArray &key) const;
+    void lookupFinished(int generation, const QString &filePath, const QByteArray &key, const QImage &image);
+    void startFrameGrabs();
+    void grabFrame(const FrameRequest &request);
+    void frameGrabbed(int generation, const FrameRequest &request, const QVideoFrame &frame);
+    void loadIndex();
+    void saveIndex();
+
+    QThreadPool pool;
+    QString cacheDirectory;
+    QCache<QString, QImage> thumbnails;
+    QSet<QString> pending;
+    QSet<QString> failed;
+    QList<FrameRequest> frameQueue;
+    int activeFrameGrabs = 0;
+    int generation = 0;
+
+    // Shared with the pool
+    QMutex indexMutex;
+    QHash<QString, IndexEntry> index;
+    bool indexChanged = false;
+};
+
+#endif // MEDIATHUMBNAILER_H
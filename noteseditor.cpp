@@ -0,0 +1,298 @@
+#include "noteseditor.h"
+#include "casetable.h"
+
+#include <QMouseEvent>
+#include <QPointer>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTimer>
+
+namespace {
+
+// "[hh:mm:ss]" with up to 12 digits of hours
+constexpr int MaxTimestampLength = 20;
+// Playback does not scroll the notes for this long after the user edits or scrolls them
+constexpr qint64 FollowPlaybackIdle = 3000;
+// Lines shown above the paragraph playback scrolls to
+constexpr int PlaybackContextLines = 2;
+
+struct Timestamp {
+    int offset = 0; // in the paragraph, at the '['
+    int length = 0;
+    qint64 milliseconds = 0;
+};
+
+// The document's trailing block separator is not part of the notes
+int notesLength(const QTextDocument *document)
+{
+    return document->characterCount() - 1;
+}
+
+QList<Timestamp> findTimestamps(const QString &text)
+{
+    QList<Timestamp> found;
+    for (qsizetype open = text.indexOf(u'['); open >= 0; open = text.indexOf(u'[', open + 1)) {
+        const QStringView rest = QStringView(text).sliced(open + 1, qMin<qsizetype>(MaxTimestampLength - 1, text.size() - open - 1));
+        const qsizetype close = rest.indexOf(u']');
+        if (close < 0)
+            continue;
+        const qint64 milliseconds = CaseTable::parseMediaTime(rest.first(close));
+        if (milliseconds >= 0)
+            found.append({int(open), int(close + 2), milliseconds});
+    }
+    return found;
+}
+
+} // namespace
+
+// The timestamps of one paragraph, owned by its block. The document deletes it
+// along with the block, which takes the timestamps out of the index.
+class NotesEditor::TimestampData : public QTextBlockUserData
+{
+public:
+    TimestampData(NotesEditor *editor, const QTextBlock &block) : editor(editor), block(block) {}
+    ~TimestampData() override
+    {
+        // While the editor itself is being destroyed, so is its index
+        if (!editor)
+            return;
+        if (editor->playbackBlock == block)
+            editor->playbackBlock = QTextBlock();
+        editor->unindex(this);
+    }
+
+    QPointer<NotesEditor> editor;
+    QTextBlock block;
+    QList<Timestamp> timestamps;
+    QList<TimestampIndex::iterator> entries;
+};
+
+NotesEditor::NotesEditor(QWidget *parent)
+    : QPlainTextEdit(parent)
+{
+    setMouseTracking(true);
+    connect(document(), &QTextDocument::contentsChange, this, &NotesEditor::contentsChange);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &NotesEditor::scheduleDecorations);
+    connect(verticalScrollBar(), &QScrollBar::actionTriggered, this, [this]() { lastInteraction.start(); });
+}
+
+QString NotesEditor::notes() const
+{
+    if (!cacheValid) {
+        cachedNotes = document()->toPlainText();
+        cacheValid = true;
+    }
+    return cachedNotes;
+}
+
+QString NotesEditor::notes(int position, int length) const
+{
+    if (cacheValid)
+        return cachedNotes.mid(position, length);
+    QTextCursor cursor(document());
+    cursor.setPosition(position);
+    cursor.setPosition(position + length, QTextCursor::KeepAnchor);
+    QString text = cursor.selectedText();
+    // As toPlainText() writes them
+    text.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+    text.replace(QChar::LineSeparator, QLatin1Char('\n'));
+    text.replace(QChar::Nbsp, QLatin1Char(' '));
+    return text;
+}
+
+void NotesEditor::setNotes(const QString &text)
+{
+    replacing = true;
+    setPlainText(text);
+    replacing = false;
+    length = notesLength(document());
+    cachedNotes = text;
+    cacheValid = text.size() == length;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+        indexBlock(block);
+    scheduleDecorations();
+    emit notesReplaced();
+}
+
+void NotesEditor::showPlaybackPosition(qint64 position)
+{
+    QTextBlock block;
+    const auto it = timestampIndex.upper_bound(position);
+    if (it != timestampIndex.begin())
+        block = std::prev(it)->second->block;
+    if (block == playbackBlock)
+        return;
+    playbackBlock = block;
+    scheduleDecorations();
+    if (!block.isValid() || (lastInteraction.isValid() && lastInteraction.elapsed() < FollowPlaybackIdle))
+        return;
+
+    // Scroll only if the paragraph is not on screen already
+    const int number = block.blockNumber();
+    const int first = firstVisibleBlock().blockNumber();
+    int last = first;
+    qreal top = blockBoundingGeometry(firstVisibleBlock()).translated(contentOffset()).top();
+    for (QTextBlock visible = firstVisibleBlock(); visible.isValid() && top < viewport()->height(); visible = visible.next()) {
+        top += blockBoundingRect(visible).height();
+        last = visible.blockNumber();
+    }
+    // The scroll bar counts visual lines
+    if (number < first || number >= last)
+        verticalScrollBar()->setValue(qMax(0, block.firstLineNumber() - PlaybackContextLines));
+}
+
+void NotesEditor::mouseMoveEvent(QMouseEvent *event)
+{
+    QPlainTextEdit::mouseMoveEvent(event);
+    if (event->buttons() == Qt::NoButton)
+        viewport()->setCursor(timestampAt(event->position().toPoint()) >= 0 ? Qt::PointingHandCursor : Qt::IBeamCursor);
+}
+
+void NotesEditor::mousePressEvent(QMouseEvent *event)
+{
+    pressedTimestamp = event->button() == Qt::LeftButton && event->modifiers() == Qt::NoModifier
+        ? timestampAt(event->position().toPoint()) : -1;
+    QPlainTextEdit::mousePressEvent(event);
+}
+
+void NotesEditor::mouseReleaseEvent(QMouseEvent *event)
+{
+    QPlainTextEdit::mouseReleaseEvent(event);
+    // A drag that started on a timestamp selects text instead
+    const qint64 timestamp = pressedTimestamp;
+    pressedTimestamp = -1;
+    if (timestamp >= 0 && event->button() == Qt::LeftButton && !textCursor().hasSelection()
+        && timestampAt(event->position().toPoint()) == timestamp) {
+        emit timestampActivated(timestamp);
+    }
+}
+
+void NotesEditor::resizeEvent(QResizeEvent *event)
+{
+    QPlainTextEdit::resizeEvent(event);
+    scheduleDecorations();
+}
+
+void NotesEditor::contentsChange(int position, int removed, int added)
+{
+    if (replacing || (removed == 0 && added == 0))
+        return;
+    const int oldLength = length;
+    const int newLength = notesLength(document());
+    length = newLength;
+    cacheValid = false;
+    lastInteraction.start();
+
+    // Paragraphs the change removed took their timestamps with them; the ones
+    // it changed or added are scanned again
+    const QTextBlock last = document()->findBlock(qMin(position + added, newLength));
+    for (QTextBlock block = document()->findBlock(position); block.isValid(); block = block.next()) {
+        indexBlock(block);
+        if (block == last)
+            break;
+    }
+    scheduleDecorations();
+
+    // A change reaching the end of the document counts its trailing separator
+    // as removed and added again
+    const int excess = qMax(0, position + removed - oldLength);
+    removed -= excess;
+    added -= excess;
+    if (position < 0 || removed < 0 || added < 0 || position + added > newLength
+        || oldLength - removed + added != newLength) {
+        emit notesEdited(0, oldLength, notes());
+        return;
+    }
+
+    emit notesEdited(position, removed, added > 0 ? notes(position, added) : QString());
+}
+
+void NotesEditor::indexBlock(const QTextBlock &block)
+{
+    QTextBlock target = block;
+    const QList<Timestamp> timestamps = findTimestamps(block.text());
+    TimestampData *data = static_cast<TimestampData *>(block.userData());
+    if (timestamps.isEmpty()) {
+        if (data)
+            target.setUserData(nullptr); // deletes the data, which unindexes it
+        return;
+    }
+    if (data) {
+        unindex(data);
+    } else {
+        data = new TimestampData(this, block);
+        target.setUserData(data);
+    }
+    data->timestamps = timestamps;
+    data->entries.reserve(timestamps.size());
+    for (const Timestamp &timestamp : timestamps)
+        data->entries.append(timestampIndex.emplace(timestamp.milliseconds, data));
+}
+
+void NotesEditor::unindex(TimestampData *data)
+{
+    for (const TimestampIndex::iterator &entry : std::as_const(data->entries))
+        timestampIndex.erase(entry);
+    data->entries.clear();
+}
+
+qint64 NotesEditor::timestampAt(const QPoint &pos) const
+{
+    const QTextCursor cursor = cursorForPosition(pos);
+    const TimestampData *data = static_cast<const TimestampData *>(cursor.block().userData());
+    if (!data)
+        return -1;
+    // Past the end of a line the cursor still lands on its last character
+    if (cursorRect(cursor).right() + fontMetrics().averageCharWidth() < pos.x())
+        return -1;
+    const int offset = cursor.positionInBlock();
+    for (const Timestamp &timestamp : data->timestamps) {
+        if (offset >= timestamp.offset && offset <= timestamp.offset + timestamp.length)
+            return timestamp.milliseconds;
+    }
+    return -1;
+}
+
+void NotesEditor::scheduleDecorations()
+{
+    if (decorationsPending)
+        return;
+    decorationsPending = true;
+    QTimer::singleShot(0, this, &NotesEditor::updateDecorations);
+}
+
+// Link styling for the timestamps on screen, and the playback paragraph
+void NotesEditor::updateDecorations()
+{
+    decorationsPending = false;
+    QList<QTextEdit::ExtraSelection> selections;
+    if (playbackBlock.isValid()) {
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(playbackBlock);
+        selection.format.setBackground(palette().color(QPalette::Highlight).darker(250));
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selections.append(selection);
+    }
+
+    QTextCharFormat linkFormat;
+    linkFormat.setForeground(palette().color(QPalette::Link));
+    linkFormat.setFontUnderline(true);
+    QTextBlock block = firstVisibleBlock();
+    qreal top = blockBoundingGeometry(block).translated(contentOffset()).top();
+    for (; block.isValid() && top < viewport()->height(); block = block.next()) {
+        top += blockBoundingRect(block).height();
+        const TimestampData *data = static_cast<const TimestampData *>(block.userData());
+        if (!data)
+            continue;
+        for (const Timestamp &timestamp : data->timestamps) {
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(block);
+            selection.cursor.setPosition(block.position() + timestamp.offset);
+            selection.cursor.setPosition(block.position() + timestamp.offset + timestamp.length, QTextCursor::KeepAnchor);
+            selection.format = linkFormat;
+            selections.append(selection);
+        }
+    }
+    setExtraSelections(selections);
+}
@@ -0,0 +1,79 @@
+#ifndef NOTESEDITOR_H
+#define NOTESEDITOR_H
+
+#include <QElapsedTimer>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+
+#include <map>
+
+// Editor for the case notes, built to stay responsive on notes of tens of
+// megabytes. The text lives in a QTextDocument, whose storage is a piece table
+// of text fragments, so an edit costs the same anywhere in the notes; the plain
+// text layout only lays out and paints the blocks in the viewport.
+//
+// Edits are reported one at a time, as the range they replaced, so the journal
+// can record just the change instead of the whole notes. The notes as a single
+// string are built only when asked for after an edit, not on every keystroke.
+//
+// "[hh:mm:ss]" timestamps in the notes are links to that media position. Each
+// paragraph keeps the timestamps found in it, and an index sorted by time
+// points back at the paragraphs; an edit rescans only the paragraphs it
+// touched. Only the timestamps in the viewport are drawn as links.
+class NotesEditor : public QPlainTextEdit
+{
+    Q_OBJECT
+
+public:
+    explicit NotesEditor(QWidget *parent = nullptr);
+
+    // The whole notes; cached until the next edit.
+    QString notes() const;
+    // Part of the notes, read from the document without building the whole.
+    QString notes(int position, int length) const;
+    // Replaces the notes, e.g. on loading a case. Emits notesReplaced(), not notesEdited().
+    void setNotes(const QString &text);
+
+    int timestampCount() const { return int(timestampIndex.size()); }
+    // Marks the paragraph with the latest timestamp at or before `position`
+    // (ms) and scrolls it into view, unless the user was just editing or
+    // scrolling the notes.
+    void showPlaybackPosition(qint64 position);
+
+signals:
+    // The `removed` characters at `position` were replaced by `inserted`.
+    void notesEdited(int position, int removed, const QString &inserted);
+    void notesReplaced();
+    void timestampActivated(qint64 position);
+
+protected:
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    class TimestampData;
+    friend class TimestampData;
+    using TimestampIndex = std::multimap<qint64, TimestampData *>;
+
+    void contentsChange(int position, int removed, int added);
+    void indexBlock(const QTextBlock &block);
+    void unindex(TimestampData *data);
+    qint64 timestampAt(const QPoint &pos) const;
+    void scheduleDecorations();
+    void updateDecorations();
+
+    mutable QString cachedNotes;
+    mutable bool cacheValid = true;
+    int length = 0;
+    bool replacing = false;
+
+    TimestampIndex timestampIndex;
+    QTextBlock playbackBlock;
+    qint64 pressedTimestamp = -1;
+    QElapsedTimer lastInteraction;
+    bool decorationsPending = false;
+};
+
+#endif // NOTESEDITOR_H
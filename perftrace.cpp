@@ -0,0 +1,248 @@
+#include "perftrace.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Written by the owning thread only. The fields are atomics so that a reader
+// copying a slot the thread is overwriting gets a stale value, not undefined
+// behaviour; such slots are then dropped by the reader.
+struct Event {
+    std::atomic<const char *> name{nullptr};
+    std::atomic<qint64> start{0};
+    std::atomic<qint64> end{0};
+};
+
+struct ThreadRing {
+    int id = 0;
+    QString threadName;
+    std::atomic<quint64> written{0};
+    std::unique_ptr<Event[]> events{new Event[PerfTrace::TraceRingEvents]};
+};
+
+struct RecordedEvent {
+    const char *name;
+    qint64 start;
+    qint64 end;
+};
+
+// Rings live as long as the process. A finished thread's ring keeps its
+// scopes for dumping until a new thread takes it over, so short-lived worker
+// threads reuse a few rings rather than each leaving one behind.
+struct Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::vector<ThreadRing *> freeRings; // oldest first
+    int nextId = 1;
+    std::atomic<qint64> clearedAt{0};
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+// Hands the thread's ring back for reuse when the thread exits
+struct RingHolder {
+    ThreadRing *ring = nullptr;
+    ~RingHolder()
+    {
+        if (!ring)
+            return;
+        Registry &r = registry();
+        QMutexLocker locker(&r.mutex);
+        r.freeRings.push_back(ring);
+    }
+};
+
+ThreadRing *threadRing()
+{
+    thread_local RingHolder holder;
+    if (holder.ring)
+        return holder.ring;
+    Registry &r = registry();
+    QMutexLocker locker(&r.mutex);
+    ThreadRing *ring;
+    if (r.freeRings.empty()) {
+        r.rings.push_back(std::make_unique<ThreadRing>());
+        ring = r.rings.back().get();
+    } else {
+        // The previous thread's scopes go; readers hold the mutex, and its thread writes no more
+        ring = r.freeRings.front();
+        r.freeRings.erase(r.freeRings.begin());
+        ring->written.store(0, std::memory_order_relaxed);
+    }
+    ring->id = r.nextId++;
+    QThread *thread = QThread::currentThread();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        ring->threadName = QStringLiteral("Main");
+    else if (!thread->objectName().isEmpty())
+        ring->threadName = thread->objectName();
+    else
+        ring->threadName = QString::fromLatin1(thread->metaObject()->className());
+    holder.ring = ring;
+    return ring;
+}
+
+// The ring's events from after the last clear(), oldest first
+QList<RecordedEvent> readRing(const ThreadRing &ring, qint64 since)
+{
+    constexpr quint64 capacity = PerfTrace::TraceRingEvents;
+    const quint64 end = ring.written.load(std::memory_order_acquire);
+    const quint64 begin = end > capacity ? end - capacity : 0;
+    QList<RecordedEvent> events;
+    events.reserve(qsizetype(end - begin));
+    for (quint64 i = begin; i < end; ++i) {
+        const Event &event = ring.events[i % capacity];
+        events.append({event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+                       event.end.load(std::memory_order_relaxed)});
+    }
+    // Slots the thread wrote to while they were copied, including the one it
+    // may be writing now, hold a mix of two events
+    const quint64 after = ring.written.load(std::memory_order_acquire);
+    const quint64 valid = after + 1 > capacity ? after + 1 - capacity : 0;
+    if (valid > begin)
+        events.remove(0, qMin<qsizetype>(events.size(), qsizetype(valid - begin)));
+    events.removeIf([since](const RecordedEvent &event) { return !event.name || event.start < since; });
+    return events;
+}
+
+void appendJsonString(QByteArray &out, const QByteArray &text)
+{
+    out += '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (uchar(c) >= 0x20)
+            out += c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+std::atomic<bool> PerfTrace::enabled{qEnvironmentVariableIntValue("DATAORGANIZER_TRACE") != 0};
+
+void PerfTrace::setEnabled(bool on)
+{
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+void PerfTrace::clear()
+{
+    registry().clearedAt.store(now(), std::memory_order_relaxed);
+}
+
+void PerfTrace::record(const char *name, qint64 start, qint64 end)
+{
+    ThreadRing *ring = threadRing();
+    const quint64 index = ring->written.load(std::memory_order_relaxed);
+    Event &event = ring->events[index % TraceRingEvents];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+int PerfTrace::threadCount()
+{
+    Registry &r = registry();
+    QMutexLocker locker(&r.mutex);
+    return int(r.rings.size());
+}
+
+QList<PerfTrace::Summary> PerfTrace::summaries()
+{
+    Registry &r = registry();
+    const qint64 since = r.clearedAt.load(std::memory_order_relaxed);
+    // The same literal may have one address per translation unit
+    QHash<QByteArray, Summary> byName;
+    QMutexLocker locker(&r.mutex);
+    for (const std::unique_ptr<ThreadRing> &ring : r.rings) {
+        const QList<RecordedEvent> events = readRing(*ring, since);
+        for (const RecordedEvent &event : events) {
+            Summary &summary = byName[QByteArray(event.name)];
+            const qint64 duration = event.end - event.start;
+            ++summary.count;
+            summary.totalNanoseconds += duration;
+            summary.maxNanoseconds = qMax(summary.maxNanoseconds, duration);
+        }
+    }
+    locker.unlock();
+
+    QList<Summary> result;
+    result.reserve(byName.size());
+    for (auto it = byName.begin(); it != byName.end(); ++it) {
+        it->name = QString::fromLatin1(it.key());
+        result.append(it.value());
+    }
+    std::sort(result.begin(), result.end(), [](const Summary &a, const Summary &b) { return a.totalNanoseconds > b.totalNanoseconds; });
+    return result;
+}
+
+// Complete ("X") events in microseconds, one track per thread
+bool PerfTrace::writeChromeTrace(const QString &filePath, QString *errorString)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorString = file.errorString();
+        return false;
+    }
+    Registry &r = registry();
+    const qint64 since = r.clearedAt.load(std::memory_order_relaxed);
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separate = [&]() {
+        if (!first)
+            out += ",\n";
+        first = false;
+    };
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QMutexLocker locker(&r.mutex);
+    QList<QList<RecordedEvent>> rings;
+    qint64 origin = std::numeric_limits<qint64>::max();
+    for (const std::unique_ptr<ThreadRing> &ring : r.rings) {
+        rings.append(readRing(*ring, since));
+        if (!rings.last().isEmpty())
+            origin = qMin(origin, rings.last().first().start);
+    }
+    for (size_t i = 0; i < r.rings.size(); ++i) {
+        const ThreadRing &ring = *r.rings.at(i);
+        separate();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(ring.id)
+             + ",\"args\":{\"name\":";
+        appendJsonString(out, ring.threadName.toUtf8());
+        out += "}}";
+        for (const RecordedEvent &event : std::as_const(rings.at(qsizetype(i)))) {
+            separate();
+            out += "{\"name\":";
+            appendJsonString(out, QByteArray(event.name));
+            out += ",\"ph\":\"X\",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(ring.id)
+                 + ",\"ts\":" + QByteArray::number(double(event.start - origin) / 1000.0, 'f', 3)
+                 + ",\"dur\":" + QByteArray::number(double(event.end - event.start) / 1000.0, 'f', 3) + '}';
+            if (out.size() > (1 << 20)) {
+                if (file.write(out) != out.size())
+                    break;
+                out.clear();
+            }
+        }
+    }
+    locker.unlock();
+    out += "\n]}\n";
+    if (file.write(out) != out.size() || !file.commit()) {
+        *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
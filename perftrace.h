@@ -0,0 +1,77 @@
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+
+// Lightweight tracing of the hot paths, for finding out what lies behind a
+// "save hung" or "video stutters" report. PERF_TRACE_SCOPE("name") records how
+// long the enclosing scope took into a ring buffer owned by the calling thread:
+// recording takes no lock and allocates nothing, and while tracing is off a
+// scope costs one relaxed atomic load. Names must be string literals. A ring
+// keeps the latest TraceRingEvents scopes of its thread and overwrites older ones;
+// when the thread exits, its ring is reused by the next thread that records.
+//
+// The scopes in the rings can be summed per name for display, or written as
+// Chrome trace event JSON, which chrome://tracing and ui.perfetto.dev open.
+class PerfTrace
+{
+public:
+    struct Summary {
+        QString name;
+        qint64 count = 0;
+        qint64 totalNanoseconds = 0;
+        qint64 maxNanoseconds = 0;
+    };
+
+    static constexpr int TraceRingEvents = 1 << 16;
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on);
+    // Forgets everything recorded so far.
+    static void clear();
+
+    // The scopes still in the rings, summed per name, by total time.
+    static QList<Summary> summaries();
+    // Number of threads whose scopes the rings hold: running ones that recorded
+    // a scope, and finished ones whose ring has not been reused yet.
+    static int threadCount();
+    static bool writeChromeTrace(const QString &filePath, QString *errorString);
+
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static void record(const char *name, qint64 start, qint64 end);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+class PerfTraceScope
+{
+public:
+    explicit PerfTraceScope(const char *name)
+        : name(PerfTrace::isEnabled() ? name : nullptr), start(this->name ? PerfTrace::now() : 0)
+    {
+    }
+    ~PerfTraceScope()
+    {
+        if (name)
+            PerfTrace::record(name, start, PerfTrace::now());
+    }
+    Q_DISABLE_COPY(PerfTraceScope)
+
+private:
+    const char *name;
+    qint64 start;
+};
+
+#define PERF_TRACE_CONCAT_(a, b) a##b
+#define PERF_TRACE_CONCAT(a, b) PERF_TRACE_CONCAT_(a, b)
+#define PERF_TRACE_SCOPE(name) PerfTraceScope PERF_TRACE_CONCAT(perfTraceScope, __LINE__)(name)
+
+#endif // PERFTRACE_H
@@ -0,0 +1,45 @@
+#include "startuptimer.h"
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QStringList>
+
+namespace {
+
+Q_LOGGING_CATEGORY(lcStartup, "dataorganizer.startup", QtInfoMsg)
+
+QElapsedTimer launchTimer;
+qint64 lastMark = 0;
+QStringList phases;
+
+} // namespace
+
+void StartupTimer::start()
+{
+    launchTimer.start();
+    lastMark = 0;
+    phases.clear();
+}
+
+void StartupTimer::mark(const char *phase)
+{
+    if (!launchTimer.isValid())
+        return;
+    const qint64 now = launchTimer.elapsed();
+    phases.append(QString::fromLatin1(phase) + u' ' + QString::number(now - lastMark));
+    lastMark = now;
+}
+
+void StartupTimer::report()
+{
+    if (!launchTimer.isValid() || phases.isEmpty())
+        return;
+    qCInfo(lcStartup, "startup: %lld ms (%s)", lastMark, qPrintable(phases.join(QStringLiteral(", "))));
+    phases.clear();
+}
+
+void StartupTimer::note(const char *event)
+{
+    if (launchTimer.isValid())
+        qCInfo(lcStartup, "%s %lld ms after launch", event, launchTimer.elapsed());
+}
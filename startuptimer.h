@@ -0,0 +1,20 @@
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+
+#include <QtGlobal>
+
+// Times the phases of a launch, from main() to the first turn of the event
+// loop. Each mark() ends a phase; report() logs them all on one line under
+// "dataorganizer.startup", for example
+//   startup: 74 ms (application 21, style 2, ui 38, window 4, show 6, event loop 3)
+class StartupTimer
+{
+public:
+    static void start();
+    static void mark(const char *phase);
+    static void report();
+    // Logs something that followed startup, with the time since launch.
+    static void note(const char *event);
+};
+
+#endif // STARTUPTIMER_H
@@ -0,0 +1,97 @@
+#include "stringpool.h"
+
+#include <QStringEncoder>
+
+namespace {
+
+constexpr int PageBits = 12;
+constexpr quint32 PageMask = (1u << PageBits) - 1;
+
+} // namespace
+
+StringPool::StringPool()
+{
+    clear();
+}
+
+StringPool::StringPool(const QSharedPointer<const Source> &source)
+    : source(source), sourceCount(source ? source->count() : 0)
+{
+    if (sourceCount == 0) {
+        clear();
+        return;
+    }
+    decodedPages.resize((sourceCount >> PageBits) + 1);
+}
+
+quint32 StringPool::intern(const QString &text)
+{
+    if (text.isEmpty())
+        return 0;
+
+    const auto it = ids.constFind(text);
+    if (it != ids.constEnd())
+        return it.value();
+
+    const quint32 id = quint32(count());
+    strings.append(text);
+    ids.insert(text, id);
+    return id;
+}
+
+const QString &StringPool::at(quint32 id) const
+{
+    if (id >= sourceCount)
+        return strings.at(id - sourceCount);
+
+    // Decode a page slot on first use; untouched pages cost nothing
+    QList<QString> &page = decodedPages[id >> PageBits];
+    if (page.isEmpty())
+        page.resize(PageMask + 1);
+    QString &text = page[id & PageMask];
+    if (text.isNull() && id != 0)
+        text = QString::fromUtf8(source->utf8(id));
+    return text;
+}
+
+QByteArray StringPool::toUtf8(quint32 id) const
+{
+    if (id >= sourceCount)
+        return strings.at(id - sourceCount).toUtf8();
+
+    const QList<QString> &page = decodedPages.at(id >> PageBits);
+    if (!page.isEmpty() && !page.at(id & PageMask).isNull())
+        return page.at(id & PageMask).toUtf8();
+    return source->utf8(id).toByteArray();
+}
+
+QByteArrayView StringPool::utf8(quint32 id, QByteArray &buffer) const
+{
+    const QString *text = decoded(id);
+    if (!text)
+        return source->utf8(id);
+    QStringEncoder encoder(QStringEncoder::Utf8);
+    buffer.resize(encoder.requiredSpace(text->size()));
+    const char *end = encoder.appendToBuffer(buffer.data(), *text);
+    return QByteArrayView(buffer.constData(), end - buffer.constData());
+}
+
+const QString *StringPool::decoded(quint32 id) const
+{
+    if (id >= sourceCount)
+        return &strings.at(id - sourceCount);
+    const QList<QString> &page = decodedPages.at(id >> PageBits);
+    if (page.isEmpty() || page.at(id & PageMask).isNull())
+        return nullptr;
+    return &page.at(id & PageMask);
+}
+
+void StringPool::clear()
+{
+    source.reset();
+    sourceCount = 0;
+    decodedPages.clear();
+    strings.clear();
+    ids.clear();
+    strings.append(QString());
+}
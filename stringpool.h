@@ -0,0 +1,57 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+// Interns cell text so that repeated values ("Person", "Vehicle", common URLs...)
+// are stored once and a table cell only needs a 32-bit id.
+// Id 0 is always the empty string. The pool is a value type built on implicitly
+// shared containers, so copying it is cheap until one of the copies is modified.
+//
+// A pool can also be backed by a Source, such as the string table of a
+// memory-mapped case file. Source strings are decoded on first access, which
+// makes at() modify the pool: do not share one across threads without copying.
+class StringPool
+{
+public:
+    class Source
+    {
+    public:
+        virtual ~Source() = default;
+        // Number of strings, including the empty string at id 0.
+        virtual quint32 count() const = 0;
+        virtual QByteArrayView utf8(quint32 id) const = 0;
+    };
+
+    StringPool();
+    explicit StringPool(const QSharedPointer<const Source> &source);
+
+    // Strings from a Source are not looked up here, so interning text that is
+    // already in the source gives it a second id. Both ids are equally valid.
+    quint32 intern(const QString &text);
+    const QString &at(quint32 id) const;
+    // UTF-8 of a string, read straight from the source when it was never decoded.
+    QByteArray toUtf8(quint32 id) const;
+    // Same without allocating: a view into the source, or the string encoded into
+    // `buffer`, which the caller reuses. Never decodes, so copies of one pool can
+    // be read like this from several threads at once.
+    QByteArrayView utf8(quint32 id, QByteArray &buffer) const;
+    // The string if the pool already holds it decoded, or nullptr. Never decodes.
+    const QString *decoded(quint32 id) const;
+    int count() const { return int(sourceCount + strings.size()); }
+    void clear();
+
+private:
+    QSharedPointer<const Source> source;
+    quint32 sourceCount = 0;
+    mutable QList<QList<QString>> decodedPages;
+    QList<QString> strings;
+    QHash<QString, quint32> ids;
+};
+
+#endif // STRINGPOOL_H
@@ -0,0 +1,297 @@
+#include "tiledimageview.h"
+
+#include <QImageReader>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+
+#include <cmath>
+
+namespace {
+
+constexpr int TileSize = 512;
+constexpr qsizetype TileCacheBytes = 256 * 1024 * 1024;
+constexpr qreal MaxScale = 16.0;
+// Tiles kept around the view when a whole level is decoded
+constexpr int LevelTileMargin = 2;
+
+} // namespace
+
+TiledImageView::TiledImageView(QWidget *parent)
+    : QWidget(parent), tiles(TileCacheBytes)
+{
+    pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() - 1));
+    setMouseTracking(false);
+    setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+}
+
+TiledImageView::~TiledImageView()
+{
+    // Reads post their results to this view, so they have to end before it does;
+    // results still queued are dropped with the view
+    pool.clear();
+    pool.waitForDone();
+}
+
+bool TiledImageView::openImage(const QString &path)
+{
+    QImageReader reader(path);
+    const QSize size = reader.size();
+    if (!reader.canRead() || !size.isValid() || size.isEmpty())
+        return false;
+
+    clear();
+    filePath = path;
+    imageSize = size;
+    clipReads = reader.supportsOption(QImageIOHandler::ScaledClipRect);
+    levels = 1;
+    while (qMax(levelSize(levels - 1).width(), levelSize(levels - 1).height()) > TileSize)
+        ++levels;
+    fitToWindow();
+    requestPreview();
+    return true;
+}
+
+void TiledImageView::clear()
+{
+    // Reads already started finish in the background and are then ignored
+    pool.clear();
+    ++imageId;
+    tiles.clear();
+    pendingTiles.clear();
+    pendingLevels.clear();
+    filePath.clear();
+    imageSize = QSize();
+    levels = 0;
+    preview = QImage();
+    update();
+}
+
+QSize TiledImageView::levelSize(int level) const
+{
+    const int divisor = 1 << level;
+    return QSize((imageSize.width() + divisor - 1) / divisor, (imageSize.height() + divisor - 1) / divisor);
+}
+
+int TiledImageView::levelForScale(qreal viewScale) const
+{
+    // The coarsest level that still has at least one pixel per screen pixel
+    const int level = viewScale >= 1.0 ? 0 : int(std::floor(std::log2(1.0 / viewScale)));
+    return qBound(0, level, levels - 1);
+}
+
+qreal TiledImageView::fitScale() const
+{
+    if (imageSize.isEmpty() || width() <= 0 || height() <= 0)
+        return 1.0;
+    return qMin(1.0, qMin(qreal(width()) / imageSize.width(), qreal(height()) / imageSize.height()));
+}
+
+void TiledImageView::fitToWindow()
+{
+    fitted = true;
+    scale = fitScale();
+    center = QPointF(imageSize.width() / 2.0, imageSize.height() / 2.0);
+    update();
+}
+
+void TiledImageView::zoomAt(const QPointF &widgetPos, qreal factor)
+{
+    if (imageSize.isEmpty())
+        return;
+    const qreal newScale = qBound(qMin(fitScale(), 1.0) / 4, scale * factor, MaxScale);
+    // Keep the image point under the cursor where it is
+    const QPointF widgetCenter(width() / 2.0, height() / 2.0);
+    const QPointF anchor = center + (widgetPos - widgetCenter) / scale;
+    center = anchor - (widgetPos - widgetCenter) / newScale;
+    scale = newScale;
+    fitted = false;
+    update();
+}
+
+QPointF TiledImageView::toWidget(const QPointF &imagePos) const
+{
+    return (imagePos - center) * scale + QPointF(width() / 2.0, height() / 2.0);
+}
+
+// A whole-image read at about the size of the widget, shown while tiles load
+void TiledImageView::requestPreview()
+{
+    const QSize target = imageSize.scaled(size().expandedTo(QSize(TileSize, TileSize)), Qt::KeepAspectRatio)
+                             .boundedTo(imageSize);
+    TiledImageView *view = this;
+    const QString path = filePath;
+    const int image = imageId;
+    pool.start([view, path, image, target]() {
+        QImageReader reader(path);
+        reader.setScaledSize(target);
+        const QImage result = reader.read();
+        QMetaObject::invokeMethod(view, [view, image, result]() {
+            if (image == view->imageId && !result.isNull()) {
+                view->preview = result;
+                view->update();
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TiledImageView::requestTile(const TileKey &key)
+{
+    if (pendingTiles.contains(key))
+        return;
+    pendingTiles.insert(key);
+
+    const QSize scaledSize = levelSize(key.level);
+    const QRect rect = QRect(key.column * TileSize, key.row * TileSize, TileSize, TileSize)
+                           .intersected(QRect(QPoint(0, 0), scaledSize));
+    TiledImageView *view = this;
+    const QString path = filePath;
+    pool.start([view, path, key, scaledSize, rect]() {
+        QImageReader reader(path);
+        if (key.level > 0)
+            reader.setScaledSize(scaledSize);
+        reader.setScaledClipRect(rect);
+        const QImage tile = reader.read();
+        QMetaObject::invokeMethod(view, [view, key, tile]() {
+            view->tileLoaded(key.image, key.level, key.column, key.row, tile);
+        }, Qt::QueuedConnection);
+    });
+}
+
+// For formats that can't read a region, decode the level and cut the tiles in
+// `tileRange` (in columns and rows) out of it. Only those are cached, so a large
+// level doesn't evict its own tiles; tiles outside it decode the level again.
+void TiledImageView::requestLevel(int level, const QRect &tileRange)
+{
+    if (pendingLevels.contains(level))
+        return;
+    pendingLevels.insert(level);
+
+    const QSize scaledSize = levelSize(level);
+    TiledImageView *view = this;
+    const QString path = filePath;
+    const int image = imageId;
+    pool.start([view, path, image, level, scaledSize, tileRange]() {
+        QImageReader reader(path);
+        if (level > 0)
+            reader.setScaledSize(scaledSize);
+        const QImage whole = reader.read();
+        for (int row = tileRange.top(); row <= tileRange.bottom() && row * TileSize < scaledSize.height(); ++row) {
+            for (int column = tileRange.left(); column <= tileRange.right() && column * TileSize < scaledSize.width(); ++column) {
+                const QImage tile = whole.isNull() ? QImage() : whole.copy(column * TileSize, row * TileSize, TileSize, TileSize);
+                QMetaObject::invokeMethod(view, [view, image, level, column, row, tile]() {
+                    view->tileLoaded(image, level, column, row, tile);
+                }, Qt::QueuedConnection);
+            }
+        }
+        // Queued after the tiles, so the level can be requested again once they are in
+        QMetaObject::invokeMethod(view, [view, image, level]() {
+            view->levelLoaded(image, level);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TiledImageView::tileLoaded(int image, int level, int column, int row, const QImage &tile)
+{
+    if (image != imageId)
+        return;
+    const TileKey key{image, level, column, row};
+    pendingTiles.remove(key);
+    // A failed read is cached too, as an empty image, so it is not retried on every paint
+    QImage *cached = new QImage(tile);
+    tiles.insert(key, cached, qMax<qsizetype>(1, tile.sizeInBytes()));
+    update();
+}
+
+void TiledImageView::levelLoaded(int image, int level)
+{
+    if (image != imageId)
+        return;
+    pendingLevels.remove(level);
+    // The view may have moved on to tiles the read did not cut
+    update();
+}
+
+void TiledImageView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    if (imageSize.isEmpty())
+        return;
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, scale < 1.0);
+
+    const QRectF imageRect(toWidget(QPointF(0, 0)), toWidget(QPointF(imageSize.width(), imageSize.height())));
+    if (!preview.isNull())
+        painter.drawImage(imageRect, preview);
+
+    const int level = levelForScale(scale);
+    const QSize scaledSize = levelSize(level);
+    const qreal levelScale = qreal(scaledSize.width()) / imageSize.width();
+    // Visible part of the level, in level pixels
+    const QRectF visible = QRectF((QPointF(0, 0) - toWidget(QPointF(0, 0))) / scale * levelScale,
+                                  QSizeF(width(), height()) / scale * levelScale)
+                               .intersected(QRectF(QPointF(0, 0), scaledSize));
+    if (visible.isEmpty())
+        return;
+    const int firstColumn = int(visible.left()) / TileSize;
+    const int lastColumn = int(std::ceil(visible.right())) / TileSize;
+    const int firstRow = int(visible.top()) / TileSize;
+    const int lastRow = int(std::ceil(visible.bottom())) / TileSize;
+    bool missing = false;
+    for (int row = firstRow; row <= lastRow && row * TileSize < scaledSize.height(); ++row) {
+        for (int column = firstColumn; column <= lastColumn && column * TileSize < scaledSize.width(); ++column) {
+            const TileKey key{imageId, level, column, row};
+            const QImage *tile = tiles.object(key);
+            if (!tile) {
+                if (clipReads)
+                    requestTile(key);
+                missing = true;
+                continue;
+            }
+            if (tile->isNull())
+                continue;
+            const QPointF topLeft(column * TileSize / levelScale, row * TileSize / levelScale);
+            const QSizeF tileSize(tile->width() / levelScale, tile->height() / levelScale);
+            painter.drawImage(QRectF(toWidget(topLeft), tileSize * scale), *tile);
+        }
+    }
+    if (missing && !clipReads) {
+        const QRect levelTiles(0, 0, (scaledSize.width() + TileSize - 1) / TileSize, (scaledSize.height() + TileSize - 1) / TileSize);
+        const QRect visibleTiles(QPoint(firstColumn, firstRow), QPoint(lastColumn, lastRow));
+        requestLevel(level, visibleTiles.adjusted(-LevelTileMargin, -LevelTileMargin, LevelTileMargin, LevelTileMargin)
+                                .intersected(levelTiles));
+    }
+}
+
+void TiledImageView::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    if (fitted)
+        fitToWindow();
+}
+
+void TiledImageView::wheelEvent(QWheelEvent *event)
+{
+    zoomAt(event->position(), std::pow(1.0015, event->angleDelta().y()));
+    event->accept();
+}
+
+void TiledImageView::mousePressEvent(QMouseEvent *event)
+{
+    lastMousePos = event->position().toPoint();
+}
+
+void TiledImageView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || imageSize.isEmpty())
+        return;
+    const QPoint pos = event->position().toPoint();
+    center -= QPointF(pos - lastMousePos) / scale;
+    lastMousePos = pos;
+    fitted = false;
+    update();
+}
+
+void TiledImageView::mouseDoubleClickEvent(QMouseEvent *)
+{
+    fitToWindow();
+}
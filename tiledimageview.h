@@ -0,0 +1,86 @@
+#ifndef TILEDIMAGEVIEW_H
+#define TILEDIMAGEVIEW_H
+
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QThreadPool>
+#include <QWidget>
+
+// Pan and zoom viewer for large still images. Nothing is decoded on the GUI
+// thread: a screen-sized preview is read first through QImageReader's scaled
+// reads, which JPEG serves by decoding at reduced resolution, then the visible
+// part is filled in from a pyramid of 512 px tiles (level n is the image scaled
+// by 1/2^n) read with scaled clip rects on a thread pool. Decoded tiles are kept
+// in a least recently used cache with a byte budget, so zooming and panning
+// back over an area does not decode it again. Formats that can't read a region
+// decode the whole level and keep only the tiles around the view; panning
+// further away decodes the level again.
+// Wheel zooms around the cursor, dragging pans, double-click fits the window.
+class TiledImageView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TiledImageView(QWidget *parent = nullptr);
+    ~TiledImageView();
+
+    // Reads only the image header; false if the file is not a readable image.
+    bool openImage(const QString &filePath);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    struct TileKey {
+        int image;
+        int level;
+        int column;
+        int row;
+        friend bool operator==(const TileKey &a, const TileKey &b)
+        {
+            return a.image == b.image && a.level == b.level && a.column == b.column && a.row == b.row;
+        }
+        friend size_t qHash(const TileKey &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.image, key.level, key.column, key.row);
+        }
+    };
+
+    QSize levelSize(int level) const;
+    int levelForScale(qreal viewScale) const;
+    qreal fitScale() const;
+    void fitToWindow();
+    void zoomAt(const QPointF &widgetPos, qreal factor);
+    QPointF toWidget(const QPointF &imagePos) const;
+    void requestPreview();
+    void requestTile(const TileKey &key);
+    void requestLevel(int level, const QRect &tileRange);
+    void tileLoaded(int image, int level, int column, int row, const QImage &tile);
+    void levelLoaded(int image, int level);
+
+    QThreadPool pool;
+    QCache<TileKey, QImage> tiles;
+    QSet<TileKey> pendingTiles;
+    QSet<int> pendingLevels;
+
+    QString filePath;
+    int imageId = 0;       // distinguishes results for an image that is no longer shown
+    QSize imageSize;
+    int levels = 0;
+    bool clipReads = false;
+    QImage preview;
+
+    qreal scale = 1.0;     // widget pixels per image pixel
+    QPointF center;        // image point shown at the middle of the widget
+    bool fitted = true;
+    QPoint lastMousePos;
+};
+
+#endif // TILEDIMAGEVIEW_H
@@ -0,0 +1,332 @@
+#include "videoanalyzer.h"
+#include "perftrace.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QImage>
+#include <QMediaPlayer>
+#include <QTimer>
+#include <QVideoFrame>
+#include <QVideoSink>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int ThumbnailWidth = 64;
+constexpr int ThumbnailHeight = 36;
+constexpr int ThumbnailPixels = ThumbnailWidth * ThumbnailHeight;
+// Luma samples averaged per thumbnail pixel, in each direction
+constexpr int SamplesPerPixel = 4;
+constexpr int HistogramBins = 32;
+
+// Video time between the frames compared, and how fast the players run
+constexpr qint64 SampleInterval = 200;
+constexpr qreal AnalysisRate = 8.0;
+// Decoders are threaded themselves, so one segment per two cores
+constexpr int MaxSegments = 8;
+constexpr qint64 MinSegmentLength = 30 * 1000;
+
+// Luma steps a thumbnail pixel has to change by to count as moving
+constexpr int PixelThreshold = 24;
+// Share of moving pixels that makes a sample motion
+constexpr float MotionThreshold = 0.01f;
+// Histogram distance of a cut to a different scene
+constexpr float CutThreshold = 0.5f;
+// Motion samples this close together are one event; shorter events are noise
+constexpr qint64 MotionMergeGap = 2000;
+constexpr qint64 MinMotionLength = 2 * SampleInterval;
+
+constexpr int PollInterval = 100;
+constexpr qint64 StallTimeout = 15 * 1000;
+
+struct Thumbnail {
+    std::array<quint8, ThumbnailPixels> luma;
+    std::array<int, HistogramBins> histogram;
+    int mean;
+};
+
+// Bytes per luma sample in plane 0 of the formats that start with a full size
+// luma plane, or 0 for the others
+int lumaPlaneSampleSize(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_YV12:
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21:
+    case QVideoFrameFormat::Format_IMC1:
+    case QVideoFrameFormat::Format_IMC2:
+    case QVideoFrameFormat::Format_IMC3:
+    case QVideoFrameFormat::Format_IMC4:
+    case QVideoFrameFormat::Format_Y8:
+        return 1;
+    case QVideoFrameFormat::Format_P010:
+    case QVideoFrameFormat::Format_P016:
+    case QVideoFrameFormat::Format_Y16:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+// Averages a grid of samples under each thumbnail pixel. `offset` picks the
+// most significant byte of wider samples.
+void downscale(const uchar *plane, qsizetype stride, int width, int height, int sampleSize, int offset, quint8 *out)
+{
+    constexpr int Columns = ThumbnailWidth * SamplesPerPixel;
+    constexpr int Rows = ThumbnailHeight * SamplesPerPixel;
+    std::array<qsizetype, Columns> columnOffsets;
+    for (int x = 0; x < Columns; ++x)
+        columnOffsets[x] = qsizetype((2 * x + 1) * width / (2 * Columns)) * sampleSize + offset;
+    for (int ty = 0; ty < ThumbnailHeight; ++ty) {
+        std::array<int, ThumbnailWidth> sums{};
+        for (int sy = 0; sy < SamplesPerPixel; ++sy) {
+            const int y = ty * SamplesPerPixel + sy;
+            const uchar *line = plane + qsizetype((2 * y + 1) * height / (2 * Rows)) * stride;
+            for (int x = 0; x < Columns; ++x)
+                sums[x / SamplesPerPixel] += line[columnOffsets[x]];
+        }
+        for (int tx = 0; tx < ThumbnailWidth; ++tx)
+            out[ty * ThumbnailWidth + tx] = quint8(sums[tx] / (SamplesPerPixel * SamplesPerPixel));
+    }
+}
+
+bool makeThumbnail(const QVideoFrame &frame, Thumbnail *thumbnail)
+{
+    const int sampleSize = lumaPlaneSampleSize(frame.pixelFormat());
+    QVideoFrame mapped(frame);
+    if (sampleSize > 0 && mapped.map(QVideoFrame::ReadOnly)) {
+        const int offset = sampleSize == 2 && Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 1 : 0;
+        downscale(mapped.bits(0), mapped.bytesPerLine(0), mapped.width(), mapped.height(), sampleSize, offset,
+                  thumbnail->luma.data());
+        mapped.unmap();
+    } else {
+        // RGB, packed YUV and frames on the GPU go through a conversion
+        const QImage image = frame.toImage().convertToFormat(QImage::Format_Grayscale8);
+        if (image.isNull() || image.width() <= 0 || image.height() <= 0)
+            return false;
+        downscale(image.constBits(), image.bytesPerLine(), image.width(), image.height(), 1, 0, thumbnail->luma.data());
+    }
+
+    thumbnail->histogram.fill(0);
+    int sum = 0;
+    for (const quint8 value : thumbnail->luma) {
+        ++thumbnail->histogram[value * HistogramBins / 256];
+        sum += value;
+    }
+    thumbnail->mean = sum / ThumbnailPixels;
+    return true;
+}
+
+// Share of pixels that changed by more than the threshold once the difference
+// in overall brightness is taken out, so auto exposure does not read as motion.
+// A plain loop over bytes, which compilers vectorize.
+float movingShare(const Thumbnail &a, const Thumbnail &b)
+{
+    const int shift = b.mean - a.mean;
+    int moving = 0;
+    for (int i = 0; i < ThumbnailPixels; ++i) {
+        const int difference = int(b.luma[i]) - int(a.luma[i]) - shift;
+        moving += (difference > PixelThreshold) | (difference < -PixelThreshold);
+    }
+    return float(moving) / ThumbnailPixels;
+}
+
+// 0 for the same distribution of brightness, 1 for no overlap at all
+float histogramDistance(const Thumbnail &a, const Thumbnail &b)
+{
+    int difference = 0;
+    for (int i = 0; i < HistogramBins; ++i)
+        difference += std::abs(a.histogram[i] - b.histogram[i]);
+    return float(difference) / (2 * ThumbnailPixels);
+}
+
+} // namespace
+
+// Objects are destroyed in reverse order, so the player lets go of the sink first
+struct VideoAnalyzer::Segment {
+    qint64 start = 0;   // ms
+    qint64 end = 0;     // ms
+    qint64 warmup = 0;  // ms; decoding starts a sample early so the first comparison falls on `start`
+    qint64 lastSample = -1;
+    qint64 analyzed = 0;
+    bool done = false;
+    Thumbnail previous;
+    std::unique_ptr<QVideoSink> sink;
+    std::unique_ptr<QMediaPlayer> player;
+};
+
+VideoAnalyzer::VideoAnalyzer(const QUrl &source, qint64 duration, QObject *parent)
+    : QThread(parent), source(source), duration(duration)
+{
+}
+
+void VideoAnalyzer::run()
+{
+    PERF_TRACE_SCOPE("analysis.run");
+    if (duration <= 0) {
+        fail(QStringLiteral("The length of the video is not known yet."));
+        return;
+    }
+
+    const int maxSegments = qBound(1, QThread::idealThreadCount() / 2, MaxSegments);
+    const int count = int(qBound<qint64>(1, duration / MinSegmentLength, maxSegments));
+    std::vector<std::unique_ptr<Segment>> segments;
+    QEventLoop loop;
+    QElapsedTimer sinceLastFrame;
+    sinceLastFrame.start();
+    int remaining = count;
+
+    auto finishSegment = [&](Segment *segment) {
+        if (segment->done)
+            return;
+        segment->done = true;
+        segment->analyzed = segment->end - segment->start;
+        segment->player->stop();
+        if (--remaining == 0)
+            loop.quit();
+    };
+
+    for (int i = 0; i < count; ++i) {
+        auto segment = std::make_unique<Segment>();
+        segment->start = duration * i / count;
+        segment->end = duration * (i + 1) / count;
+        segment->warmup = qMax<qint64>(0, segment->start - SampleInterval);
+        segment->sink = std::make_unique<QVideoSink>();
+        segment->player = std::make_unique<QMediaPlayer>();
+        // No audio output: nothing is heard, and no audio device is opened
+        segment->player->setVideoSink(segment->sink.get());
+        Segment *s = segment.get();
+        // Frames are handed over on this thread, whichever thread decoded them
+        connect(s->sink.get(), &QVideoSink::videoFrameChanged, s->sink.get(), [&, s](const QVideoFrame &frame) {
+            if (s->done || !frame.isValid() || frame.startTime() < 0)
+                return;
+            sinceLastFrame.restart();
+            analyzeFrame(s, frame);
+            if (s->lastSample >= s->end)
+                finishSegment(s);
+        });
+        connect(s->player.get(), &QMediaPlayer::mediaStatusChanged, s->player.get(), [&, s](QMediaPlayer::MediaStatus status) {
+            if (status == QMediaPlayer::LoadedMedia && !s->done) {
+                s->player->setPlaybackRate(AnalysisRate);
+                s->player->setPosition(s->warmup);
+                s->player->play();
+            } else if (status == QMediaPlayer::EndOfMedia) {
+                finishSegment(s);
+            } else if (status == QMediaPlayer::InvalidMedia) {
+                fail(QStringLiteral("The video could not be decoded."));
+                loop.quit();
+            }
+        });
+        connect(s->player.get(), &QMediaPlayer::errorOccurred, s->player.get(), [&](QMediaPlayer::Error, const QString &message) {
+            fail(QStringLiteral("The video could not be analyzed: ") + message);
+            loop.quit();
+        });
+        segments.push_back(std::move(segment));
+    }
+
+    QTimer poll;
+    connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (isInterruptionRequested()) {
+            loop.quit();
+            return;
+        }
+        if (sinceLastFrame.elapsed() > StallTimeout) {
+            fail(QStringLiteral("The video stopped decoding."));
+            loop.quit();
+            return;
+        }
+        qint64 analyzed = 0;
+        for (const std::unique_ptr<Segment> &segment : segments)
+            analyzed += segment->analyzed;
+        emit progress(analyzed, duration);
+    });
+    poll.start(PollInterval);
+
+    for (const std::unique_ptr<Segment> &segment : segments)
+        segment->player->setSource(source);
+    loop.exec();
+    poll.stop();
+    for (const std::unique_ptr<Segment> &segment : segments)
+        segment->player->stop();
+    segments.clear();
+
+    if (analysisResult == Failed || isInterruptionRequested())
+        return;
+    detected = proposeEvents(samples);
+    analysisResult = Analyzed;
+}
+
+void VideoAnalyzer::analyzeFrame(Segment *segment, const QVideoFrame &frame)
+{
+    const qint64 time = frame.startTime() / 1000;
+    // Frames from before the seek took effect
+    if (time < segment->warmup)
+        return;
+    if (segment->lastSample >= 0 && time - segment->lastSample < SampleInterval && time < segment->end)
+        return;
+
+    PERF_TRACE_SCOPE("analysis.frame");
+    Thumbnail thumbnail;
+    if (!makeThumbnail(frame, &thumbnail))
+        return;
+    if (segment->lastSample >= 0) {
+        samples.append({segment->lastSample, time, movingShare(segment->previous, thumbnail),
+                        histogramDistance(segment->previous, thumbnail)});
+    }
+    segment->previous = thumbnail;
+    segment->lastSample = time;
+    segment->analyzed = qBound<qint64>(0, time - segment->start, segment->end - segment->start);
+}
+
+void VideoAnalyzer::fail(const QString &message)
+{
+    if (analysisResult == Failed)
+        return;
+    analysisResult = Failed;
+    error = message;
+}
+
+QList<DetectedEvent> VideoAnalyzer::proposeEvents(QList<Sample> samples)
+{
+    std::sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b) { return a.time < b.time; });
+
+    QList<DetectedEvent> events;
+    DetectedEvent motion;
+    bool inMotion = false;
+    qint64 lastCut = -1;
+    auto endMotion = [&]() {
+        if (inMotion && motion.end - motion.start >= MinMotionLength)
+            events.append(motion);
+        inMotion = false;
+    };
+    for (const Sample &sample : std::as_const(samples)) {
+        if (sample.cut >= CutThreshold) {
+            // Segments overlap by a sample, so the same cut can be seen twice
+            if (lastCut < 0 || sample.time - lastCut > SampleInterval)
+                events.append({DetectedEvent::SceneChange, sample.time, sample.time, sample.cut});
+            lastCut = sample.time;
+            // Every pixel changes at a cut; that is not motion
+            continue;
+        }
+        if (sample.motion < MotionThreshold)
+            continue;
+        if (inMotion && sample.previousTime - motion.end <= MotionMergeGap) {
+            motion.end = qMax(motion.end, sample.time);
+            motion.strength = qMax(motion.strength, sample.motion);
+            continue;
+        }
+        endMotion();
+        motion = {DetectedEvent::Motion, sample.previousTime, sample.time, sample.motion};
+        inMotion = true;
+    }
+    endMotion();
+
+    std::stable_sort(events.begin(), events.end(), [](const DetectedEvent &a, const DetectedEvent &b) { return a.start < b.start; });
+    return events;
+}
@@ -0,0 +1,74 @@
+#ifndef VIDEOANALYZER_H
+#define VIDEOANALYZER_H
+
+#include <QList>
+#include <QThread>
+#include <QUrl>
+
+class QVideoFrame;
+
+// A stretch of video the analysis proposes as an event.
+struct DetectedEvent
+{
+    enum Kind { Motion, SceneChange };
+
+    Kind kind = Motion;
+    qint64 start = 0;      // ms
+    qint64 end = 0;        // ms; equal to start for a scene change
+    float strength = 0.0f; // most of the picture that moved, or how different the new scene is (0 to 1)
+};
+
+// Looks for motion and scene changes in a video on its own thread, to propose
+// rows for the events table. The video is cut into segments, one per pair of
+// cores up to a limit, and each segment is decoded by a headless QMediaPlayer
+// playing it at several times normal speed into a QVideoSink; the player the
+// user is watching is left alone.
+//
+// A few frames a second are reduced to a small luma thumbnail, read straight
+// from the luma plane of YUV frames without converting them. Each thumbnail is
+// compared with the one before it pixel by pixel, after evening out overall
+// brightness, for motion, and by luma histogram for cuts. Motion samples close
+// together are joined into intervals.
+// Cancel with requestInterruption(); result() and events() are valid once finished() is emitted.
+class VideoAnalyzer : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Result { Analyzed, Cancelled, Failed };
+
+    VideoAnalyzer(const QUrl &source, qint64 duration, QObject *parent = nullptr);
+
+    Result result() const { return analysisResult; }
+    QString errorString() const { return error; }
+    // In order of start time.
+    const QList<DetectedEvent> &events() const { return detected; }
+
+signals:
+    void progress(qint64 analyzed, qint64 duration);
+
+protected:
+    void run() override;
+
+private:
+    struct Segment;
+    struct Sample {
+        qint64 previousTime;
+        qint64 time;
+        float motion;
+        float cut;
+    };
+
+    void analyzeFrame(Segment *segment, const QVideoFrame &frame);
+    void fail(const QString &message);
+    static QList<DetectedEvent> proposeEvents(QList<Sample> samples);
+
+    QUrl source;
+    qint64 duration;
+    QList<Sample> samples;
+    QList<DetectedEvent> detected;
+    Result analysisResult = Cancelled;
+    QString error;
+};
+
+#endif // VIDEOANALYZER_H
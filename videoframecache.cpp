@@ -0,0 +1,172 @@
+#include "videoframecache.h"
+#include "perftrace.h"
+
+#include <QMediaPlayer>
+#include <QVideoSink>
+
+#include <algorithm>
+
+namespace {
+
+// About three seconds of 30 fps video. Frames may hold decoder surfaces, so
+// the count stays modest.
+constexpr int Capacity = 96;
+// How much video one prefetch decodes, and how fast the headless player runs
+constexpr qint64 PrefetchWindow = 1500 * 1000;
+constexpr qreal PrefetchRate = 4.0;
+
+} // namespace
+
+VideoFrameCache::VideoFrameCache(QObject *parent)
+    : QObject(parent)
+{
+    frames.reserve(Capacity + 1);
+    prefetchPlayer = new QMediaPlayer(this);
+    prefetchSink = new QVideoSink(this);
+    // No audio output: the prefetch player is never heard
+    prefetchPlayer->setVideoSink(prefetchSink);
+    connect(prefetchSink, &QVideoSink::videoFrameChanged, this, &VideoFrameCache::prefetchedFrame);
+    connect(prefetchPlayer, &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
+        if (status == QMediaPlayer::EndOfMedia)
+            prefetchStart = prefetchEnd = -1;
+    });
+}
+
+void VideoFrameCache::setSource(const QUrl &source)
+{
+    clear();
+    prefetchPlayer->setSource(source);
+}
+
+void VideoFrameCache::clear()
+{
+    prefetchPlayer->stop();
+    prefetchStart = prefetchEnd = -1;
+    frames.clear();
+    playhead = 0;
+    frameMicroseconds = 40000;
+}
+
+void VideoFrameCache::addFrame(const QVideoFrame &frame)
+{
+    PERF_TRACE_SCOPE("media.frame");
+    if (!frame.isValid() || frame.startTime() < 0)
+        return;
+    playhead = frame.startTime();
+    insertFrame(frame);
+}
+
+QVideoFrame VideoFrameCache::frameAt(qint64 position) const
+{
+    const int i = indexAt(position * 1000);
+    return i >= 0 ? frames.at(i) : QVideoFrame();
+}
+
+QVideoFrame VideoFrameCache::adjacentFrame(qint64 position, int direction) const
+{
+    const int i = indexAt(position * 1000);
+    if (i < 0)
+        return QVideoFrame();
+    const int next = direction > 0 ? i + 1 : i - 1;
+    if (next < 0 || next >= frames.size())
+        return QVideoFrame();
+    // Only a neighbour in time, not the far side of a stretch that was never decoded
+    return follows(qMin(i, next)) ? frames.at(next) : QVideoFrame();
+}
+
+void VideoFrameCache::prefetch(qint64 position, int direction)
+{
+    if (prefetchPlayer->source().isEmpty())
+        return;
+    const qint64 time = position * 1000;
+    playhead = time;
+    const qint64 start = direction > 0 ? time : qMax<qint64>(0, time - PrefetchWindow);
+    qint64 end = start + PrefetchWindow;
+    if (prefetchPlayer->duration() > 0)
+        end = qMin(end, prefetchPlayer->duration() * 1000);
+
+    if (prefetchStart >= 0 && time >= prefetchStart && time <= prefetchEnd)
+        return;
+    if (isCached(start, end))
+        return;
+
+    prefetchStart = start;
+    prefetchEnd = end;
+    prefetchPlayer->setPlaybackRate(PrefetchRate);
+    prefetchPlayer->setPosition(start / 1000);
+    prefetchPlayer->play();
+}
+
+void VideoFrameCache::prefetchedFrame(const QVideoFrame &frame)
+{
+    PERF_TRACE_SCOPE("media.prefetchFrame");
+    if (prefetchStart < 0 || !frame.isValid() || frame.startTime() < 0)
+        return;
+    // Frames from before the seek took effect
+    if (frame.startTime() + frameMicroseconds < prefetchStart)
+        return;
+    insertFrame(frame);
+    if (frame.startTime() >= prefetchEnd) {
+        prefetchPlayer->pause();
+        prefetchStart = prefetchEnd = -1;
+    }
+}
+
+void VideoFrameCache::insertFrame(const QVideoFrame &frame)
+{
+    if (frame.endTime() > frame.startTime())
+        frameMicroseconds = frame.endTime() - frame.startTime();
+
+    const auto byStart = [](const QVideoFrame &a, qint64 start) { return a.startTime() < start; };
+    const auto it = std::lower_bound(frames.begin(), frames.end(), frame.startTime(), byStart);
+    if (it != frames.end() && it->startTime() == frame.startTime())
+        *it = frame;
+    else
+        frames.insert(it, frame);
+
+    // Evict from whichever end lies farther from the playhead
+    while (frames.size() > Capacity) {
+        if (playhead - frames.first().startTime() > frames.last().startTime() - playhead)
+            frames.removeFirst();
+        else
+            frames.removeLast();
+    }
+}
+
+// Whether every frame from `start` to `end` (microseconds) is cached
+bool VideoFrameCache::isCached(qint64 start, qint64 end) const
+{
+    int i = indexAt(start);
+    if (i < 0)
+        return false;
+    while (endTime(frames.at(i)) < end) {
+        if (!follows(i))
+            return false;
+        ++i;
+    }
+    return true;
+}
+
+// Whether the frame after `i` is the next one in the video
+bool VideoFrameCache::follows(int i) const
+{
+    return i + 1 < frames.size() && frames.at(i + 1).startTime() - endTime(frames.at(i)) <= frameMicroseconds / 2;
+}
+
+// The frame showing at `microseconds`, or -1
+int VideoFrameCache::indexAt(qint64 microseconds) const
+{
+    const auto afterStart = [](qint64 time, const QVideoFrame &frame) { return time < frame.startTime(); };
+    const auto it = std::upper_bound(frames.cbegin(), frames.cend(), microseconds, afterStart);
+    if (it == frames.cbegin())
+        return -1;
+    const int i = int(it - frames.cbegin()) - 1;
+    return microseconds < endTime(frames.at(i)) ? i : -1;
+}
+
+qint64 VideoFrameCache::endTime(const QVideoFrame &frame) const
+{
+    if (!frame.isValid())
+        return -1;
+    return frame.endTime() > frame.startTime() ? frame.endTime() : frame.startTime() + frameMicroseconds;
+}
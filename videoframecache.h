@@ -0,0 +1,62 @@
+#ifndef VIDEOFRAMECACHE_H
+#define VIDEOFRAMECACHE_H
+
+#include <QList>
+#include <QObject>
+#include <QUrl>
+#include <QVideoFrame>
+
+class QMediaPlayer;
+class QVideoSink;
+
+// Decoded frames around the playhead, for stepping frame by frame and for
+// scrubbing without waiting on a seek. Frames the player shows are added as
+// they arrive, so the last few seconds of playback are always at hand; on
+// top of that a headless second player decodes ahead of the playhead in the
+// direction the user is moving. The frames live in a fixed number of slots
+// ordered by time; once they are full, the frames farthest from the playhead
+// make room.
+class VideoFrameCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VideoFrameCache(QObject *parent = nullptr);
+
+    void setSource(const QUrl &source);
+    void clear();
+
+    // For frames shown by the main player.
+    void addFrame(const QVideoFrame &frame);
+
+    // The cached frame on screen at `position` (ms), or an invalid frame.
+    QVideoFrame frameAt(qint64 position) const;
+    // The cached frame right after (direction > 0) or before the one at
+    // `position`, or an invalid frame if it has not been decoded.
+    QVideoFrame adjacentFrame(qint64 position, int direction) const;
+    // Milliseconds between frames, as far as the frames seen so far tell.
+    qint64 frameDuration() const { return qMax<qint64>(1, frameMicroseconds / 1000); }
+
+    // Decodes the stretch of video ahead of `position` in `direction`, unless
+    // it is already cached or being decoded.
+    void prefetch(qint64 position, int direction);
+
+private:
+    void insertFrame(const QVideoFrame &frame);
+    void prefetchedFrame(const QVideoFrame &frame);
+    bool isCached(qint64 start, qint64 end) const;
+    bool follows(int i) const;
+    int indexAt(qint64 microseconds) const;
+    qint64 endTime(const QVideoFrame &frame) const;
+
+    QList<QVideoFrame> frames; // ordered by start time
+    qint64 playhead = 0;       // microseconds
+    qint64 frameMicroseconds = 40000;
+
+    QMediaPlayer *prefetchPlayer;
+    QVideoSink *prefetchSink;
+    qint64 prefetchStart = -1; // microseconds; -1 while idle
+    qint64 prefetchEnd = -1;
+};
+
+#endif // VIDEOFRAMECACHE_H